@@ -23,6 +23,8 @@
 #include <iostream>
 #include <list>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <glib.h>
 #include "common.h"
 #include <sys/time.h>
@@ -32,13 +34,22 @@
 #include "messageUtils.h"
 #include "log.h"
 #include "utils.h"
+#include "focusEngine.h"
 
 LSHandle *GetLSService();
 
 #define REQUEST_TYPE_POLICY_CONFIG "audiofocuspolicy.json"
 #define AF_API_GET_STATUS "/getStatus"
+#define AF_GET_STATUS_ALL_DISPLAYS_KEY AF_API_GET_STATUS "/all"
 #define AF_API_REQUEST_FOCUS "requestFocus"
+#define AF_API_REQUEST_FOCUS_BATCH "requestFocusBatch"
+#define AF_SUBSCRIPTION_LIST "AFSubscriptionList"
 #define CONFIG_DIR_PATH "/etc/palm/audiofocusmanager"
+#define AF_POLICY_RELOAD_DELAY_MS 200
+#define AF_MAX_BATCH_SIZE 32
+//getStatus versions carry a per process epoch above the generation, within the 53 bits of a json integer
+#define AF_STATUS_VERSION_GENERATION_BITS 32
+#define AF_STATUS_VERSION_EPOCH_RANGE (1u << 21)
 
 #define AF_ERR_CODE_INVALID_SCHEMA 1
 #define AF_ERR_CODE_UNKNOWN_REQUEST 2
@@ -49,6 +60,12 @@ LSHandle *GetLSService();
 #define DISPLAY_ID_1 1
 #define DISPLAY_ID_2 2
 
+#if defined(WEBOS_SOC_AUTO)
+#define AF_DEFAULT_DISPLAY_COUNT 3
+#else
+#define AF_DEFAULT_DISPLAY_COUNT 2
+#endif
+
 #if defined(WEBOS_SOC_AUTO)
 #define UNKNOWN_SESSION_ID -1
 #define HOST_SESSION        "host"
@@ -73,7 +90,7 @@ LSHandle *GetLSService();
 class AudioFocusManager
 {
 public:
-    ~AudioFocusManager(){};
+    ~AudioFocusManager();
     bool init(GMainLoop *);
     static bool _requestFocus(LSHandle *sh, LSMessage *message, void *data)
     {
@@ -89,10 +106,36 @@ public:
     {
         return ((AudioFocusManager *) data)->getStatus(sh, message, NULL);
     }
+
+    static bool _requestFocusBatch(LSHandle *sh, LSMessage *message, void *data)
+    {
+        return ((AudioFocusManager *) data)->requestFocusBatch(sh, message, NULL);
+    }
+
+    static bool _releaseFocusBatch(LSHandle *sh, LSMessage *message, void *data)
+    {
+        return ((AudioFocusManager *) data)->releaseFocusBatch(sh, message, NULL);
+    }
     static bool _cancelFunction(LSHandle *sh, LSMessage *message, void *data)
     {
        return ((AudioFocusManager *) data)->cancelFunction(sh, message, NULL);
     }
+    static gboolean _flushStatusBroadcasts(gpointer data)
+    {
+        ((AudioFocusManager *) data)->mBroadcastSourceId = 0;
+        ((AudioFocusManager *) data)->flushStatusBroadcasts();
+        return G_SOURCE_REMOVE;
+    }
+    static gboolean _requestPolicyConfigChanged(gint fd, GIOCondition condition, gpointer data)
+    {
+        return ((AudioFocusManager *) data)->requestPolicyConfigChanged(fd, condition);
+    }
+    static gboolean _reloadRequestPolicy(gpointer data)
+    {
+        ((AudioFocusManager *) data)->mPolicyReloadSourceId = 0;
+        ((AudioFocusManager *) data)->reloadRequestPolicy();
+        return G_SOURCE_REMOVE;
+    }
 
     static AudioFocusManager *getInstance();
     static void deleteInstance();
@@ -107,8 +150,18 @@ public:
 #endif
 private:
 
-    RequestPolicyInfoMap mAFRequestPolicyInfo;
-    DisplayInfoMap mDisplayInfoMap;
+    FocusEngine mFocusEngine;
+    //Entries granted with each subscription, removed with it on cancel
+    std::unordered_map<LSMessage*, FOCUS_SUBSCRIPTION_T> mFocusSubscriptions;
+    //Subscription the events of each entry go to
+    std::unordered_map<uint64_t, LSMessage*> mHandleSubscriptions;
+    std::set<int> mDirtyDisplays;
+    guint mBroadcastSourceId {0};
+    guint mBroadcastCoalesceMs {0};
+    uint64_t mStatusVersionEpoch {0};
+    int mPolicyWatchFd {-1};
+    guint mPolicyWatchSourceId {0};
+    guint mPolicyReloadSourceId {0};
     static AudioFocusManager *AFService;
     static LSMethod rootMethod[];
 #if defined(WEBOS_SOC_AUTO)
@@ -122,22 +175,35 @@ private:
     bool releaseFocus(LSHandle *sh, LSMessage *message, void *data);
     bool requestFocus(LSHandle *sh, LSMessage *message, void *data);
     bool getStatus(LSHandle *sh, LSMessage *message, void *data);
+    bool requestFocusBatch(LSHandle *sh, LSMessage *message, void *data);
+    bool releaseFocusBatch(LSHandle *sh, LSMessage *message, void *data);
     bool cancelFunction(LSHandle *sh, LSMessage *message, void *data);
 
-    bool validateDisplayId(int displayId);
+    void scheduleStatusBroadcast(int displayId);
+    void flushStatusBroadcasts();
     void broadcastStatusToSubscribers(int displayId);
-    pbnjson::JValue getStatusPayload(const int& displayId);
+    std::string getStatusReply(const int& displayId, bool subscribed, int64_t knownVersion = -1);
+    std::string getAllDisplaysStatusReply(bool subscribed, int64_t knownVersion = -1);
+    uint64_t makeStatusVersion(uint64_t generation) const;
+    static std::string getStatusSubscriptionKey(int displayId, bool delta = false);
+    static bool hasStatusSubscribers(const std::string& key);
+    std::string getStatusDeltaSnapshotReply(const int& displayId, const DisplayFocusState& displayInfo);
+    void broadcastStatusDelta(int displayId, DisplayFocusState& displayInfo);
+    const std::string& getStatusPayloadString(const int& displayId);
+    void appendStatusPayload(std::string& out, const int& displayId, const DisplayFocusState& displayInfo);
+    void appendAppInfoArray(std::string& out, const AppInfoList& appList, bool withEntryId = false);
+    void appendAppInfo(std::string& out, const APP_INFO_T& appInfo, bool withEntryId);
     bool loadRequestPolicyJsonConfig();
+    bool loadRequestPolicyImage();
+    void applyConfigOptions(int32_t broadcastCoalesceMs, int32_t displayCount);
+    void watchRequestPolicyConfig();
+    gboolean requestPolicyConfigChanged(gint fd, GIOCondition condition);
+    bool reloadRequestPolicy();
     void printRequestPolicyJsonInfo();
-    void sendApplicationResponse(LSHandle *serviceHandle, LSMessage *message, const std::string& payload);
-    bool checkGrantedAlready(LSHandle *sh, LSMessage *message, std::string applicationId, const int& displayId, const std::string& requestType);
-    bool checkFeasibility(const int& displayId, const std::string& newRequestType);
-    void updateDisplayActiveAppList(const int& displayId, const std::string& appId, const std::string& requestType, const std::string& streamType);
-    void manageAppSubscription(const std::string& applicationId, const std::string& payload, const char operation);
-    bool checkIncomingPair(const std::string& newRequestType, const std::list<APP_INFO_T>& appList);
-    bool pausedAppToActive(DISPLAY_INFO_T& displayInfo, const std::string& removedRequest);
-    bool isIncomingPairRequestTypeActive(const std::string& requestType, const DISPLAY_INFO_T& displayInfo);
-    std::string getFocusPolicyType(const std::string& newRequestType, const pbnjson::JValue& incomingRequestInfo);
+    void sendApplicationResponse(LSHandle *serviceHandle, LSMessage *message, const char* result, uint64_t focusHandle = 0);
+    void manageAppSubscription(const AppNotificationList& notifications);
+    void addFocusSubscription(LSMessage *message, const std::vector<uint64_t>& focusHandles, bool batch);
+    void removeFocusSubscription(LSMessage *message);
 };
 
 #endif
@@ -23,29 +23,36 @@
 #include <map>
 #include <string>
 #include <list>
+#include <vector>
+#include <cstdint>
 #include <pbnjson.hpp>
+#include "focusTypes.h"
 
-typedef struct RequestTypePolicyInfo
+//Outcome of one item of requestFocusBatch
+typedef struct BatchItemResult
 {
-    int priority {-1};
-    pbnjson::JValue incomingRequestInfo {pbnjson::Array()};
-}REQUEST_TYPE_POLICY_INFO_T;
+    std::string name;
+    int requestTypeId {AF_INVALID_REQUEST_TYPE};
+    bool granted {false};
+    const char *result {nullptr};
+    const char *errorText {nullptr};
+    int errorCode {0};
+    uint64_t focusHandle {0};
+}BATCH_ITEM_RESULT_T;
 
-typedef struct AppInfo
+//requestFocus or requestFocusBatch subscription, with the focus handles of the entries it was granted
+typedef struct FocusSubscription
 {
-    std::string appId;
-    std::string requestType;
-    std::string streamType;
-}APP_INFO_T;
+    std::vector<uint64_t> focusHandles;
+    bool batch {false};                 //events name their entry with its focusHandle
+}FOCUS_SUBSCRIPTION_T;
 
-typedef struct DisplayInfo
+//Pre-rendered reply of a focus result sent to the application
+typedef struct FocusResultReply
 {
-    std::list<APP_INFO_T> activeAppList;
-    std::list<APP_INFO_T> pausedAppList;
-}DISPLAY_INFO_T;
-
-using RequestPolicyInfoMap = std::map<std::string, REQUEST_TYPE_POLICY_INFO_T>;
-using DisplayInfoMap = std::map<int, DISPLAY_INFO_T>;
+    const char *result;
+    const char *reply;
+}AF_FOCUS_RESULT_REPLY_T;
 
 struct CLSError : public LSError
 {
@@ -0,0 +1,72 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+//Generated by afpolicyc --header from audiofocuspolicy.json, do not edit
+
+#ifndef DEFAULT_FOCUS_POLICY_H_
+#define DEFAULT_FOCUS_POLICY_H_
+
+#include "focusTypes.h"
+
+/*
+ * Built-in copy of the shipped audiofocuspolicy.json, used when no policy can be loaded
+ * from the filesystem. Request type ids follow the order of the json, as in FocusPolicy.
+ */
+class DefaultFocusPolicy
+{
+public:
+    static constexpr int requestTypeCount = 5;
+
+    static constexpr const char* getRequestTypeName(int requestTypeId)
+    {
+        constexpr const char* requestTypeNames[requestTypeCount] = {
+            "AFREQUEST_GAIN",
+            "AFREQUEST_TRANSIENT",
+            "AFREQUEST_CALL",
+            "AFREQUEST_RECORD",
+            "AFREQUEST_TRANSIENT_MAY_DUCK",
+        };
+        return requestTypeNames[requestTypeId];
+    }
+
+    static constexpr int getPriority(int requestTypeId)
+    {
+        constexpr int priorities[requestTypeCount] = {5, 4, 1, 2, 3};
+        return priorities[requestTypeId];
+    }
+
+    //Rows are the active request type, columns the incoming one
+    static constexpr FOCUS_ACTION_E getAction(int activeRequestTypeId, int incomingRequestTypeId)
+    {
+        constexpr FOCUS_ACTION_E actions[requestTypeCount][requestTypeCount] = {
+            //AFREQUEST_GAIN
+            {eFocusActionLost, eFocusActionPause, eFocusActionPause, eFocusActionPause, eFocusActionMix},
+            //AFREQUEST_TRANSIENT
+            {eFocusActionNone, eFocusActionLost, eFocusActionLost, eFocusActionLost, eFocusActionMix},
+            //AFREQUEST_CALL
+            {eFocusActionNone, eFocusActionMix, eFocusActionLost, eFocusActionMix, eFocusActionMix},
+            //AFREQUEST_RECORD
+            {eFocusActionNone, eFocusActionMix, eFocusActionLost, eFocusActionLost, eFocusActionMix},
+            //AFREQUEST_TRANSIENT_MAY_DUCK
+            {eFocusActionMix, eFocusActionMix, eFocusActionMix, eFocusActionMix, eFocusActionMix},
+        };
+        return actions[activeRequestTypeId][incomingRequestTypeId];
+    }
+};
+
+#endif //DEFAULT_FOCUS_POLICY_H_
@@ -0,0 +1,122 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef DISPLAY_FOCUS_STATE_H_
+#define DISPLAY_FOCUS_STATE_H_
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+#include "focusTypes.h"
+
+typedef std::list<APP_INFO_T> AppInfoList;
+
+/*
+ * Active and paused requests of a display.
+ * Entries only ever move with list splices, so an iterator stays valid until the
+ * entry is removed. Next to the two lists an appId index gives direct access to
+ * all entries of an application, an entryId index to a single entry, and per request type counters give the set of
+ * active and paused request types used by FocusPolicy::getFeasibility.
+ * Every insertion goes to the end of a list, which pausedAppToActive relies on.
+ * Each change gives the display a new generation, which keys the serialized status of the
+ * display so that it is only rebuilt after a real change. Generations come from one counter
+ * shared by all displays, the last one given out changes with any display.
+ * The entries seen by the last status broadcast are kept as a snapshot, so that
+ * delta subscribers only get what was removed and appended since then.
+ */
+class DisplayFocusState
+{
+public:
+    DisplayFocusState() = default;
+    //The appId index holds iterators into the lists, a copy would point into the original
+    DisplayFocusState(const DisplayFocusState&) = delete;
+    DisplayFocusState& operator=(const DisplayFocusState&) = delete;
+
+    const AppInfoList& getActiveAppList() const                     { return mActiveAppList; }
+    const AppInfoList& getPausedAppList() const                     { return mPausedAppList; }
+    AppInfoList::iterator activeBegin()                             { return mActiveAppList.begin(); }
+    AppInfoList::iterator activeEnd()                               { return mActiveAppList.end(); }
+    AppInfoList::iterator pausedBegin()                             { return mPausedAppList.begin(); }
+    AppInfoList::iterator pausedEnd()                               { return mPausedAppList.end(); }
+    uint32_t getActiveRequestTypeMask() const                       { return mActiveRequestTypeMask; }
+    uint32_t getPausedRequestTypeMask() const                       { return mPausedRequestTypeMask; }
+    uint64_t getGeneration() const                                  { return mGeneration; }
+    static uint64_t getLastGeneration();
+
+    // Serialized status of the display, nullptr if the lists changed since it was set
+    const std::string* getCachedStatus() const
+                        { return (mCachedStatusGeneration == mGeneration) ? &mCachedStatus : nullptr; }
+    const std::string& setCachedStatus(std::string status);
+
+    // Sequence of the last broadcast snapshot, and whether the lists changed since
+    uint64_t getStatusSequence() const                              { return mStatusSequence; }
+    bool isStatusSnapshotCurrent() const                            { return mSnapshotGeneration == mGeneration; }
+    // Entries removed from, and appended to, the lists since the last snapshot
+    void getStatusDelta(std::vector<uint64_t>& removedEntryIds, std::vector<const APP_INFO_T*>& appendedActive,
+                        std::vector<const APP_INFO_T*>& appendedPaused) const;
+    // Records the current lists as the last broadcast state, returns the new sequence
+    uint64_t takeStatusSnapshot();
+
+    AppInfoList::iterator addActiveApp(const APP_INFO_T& appInfo);
+    AppInfoList::iterator removeActiveApp(AppInfoList::iterator itActive);
+    AppInfoList::iterator removePausedApp(AppInfoList::iterator itPaused);
+    AppInfoList::iterator removeApp(AppInfoList::iterator itApp);
+    AppInfoList::iterator pauseActiveApp(AppInfoList::iterator itActive);
+    AppInfoList::iterator resumePausedApp(AppInfoList::iterator itPaused);
+
+    // Renumbers the request types after a policy change, requestTypeMap gives the new id of each old one.
+    // Entries mapped to AF_INVALID_REQUEST_TYPE are removed and returned in removedApps.
+    void remapRequestTypes(const std::vector<int>& requestTypeMap, std::vector<APP_INFO_T>& removedApps);
+
+    // Entry of appId with the given request type, in the paused or in the active list
+    bool findApp(int appId, int requestTypeId, AppInfoList::iterator& itApp);
+    // First entry of appId in the paused list, or else the first one in the active list.
+    // A streamType other than -1 only matches the entries of that stream.
+    bool findFirstApp(int appId, AppInfoList::iterator& itApp, int streamType = -1);
+    // Entry with the given entryId, wherever it is
+    bool findEntry(uint64_t entryId, AppInfoList::iterator& itApp);
+
+private:
+    AppInfoList mActiveAppList;
+    AppInfoList mPausedAppList;
+    std::unordered_map<int, std::vector<AppInfoList::iterator>> mAppIndex;
+    std::unordered_map<uint64_t, AppInfoList::iterator> mEntryIndex;
+    unsigned int mActiveRequestTypeCount[AF_MAX_REQUEST_TYPES] {};
+    unsigned int mPausedRequestTypeCount[AF_MAX_REQUEST_TYPES] {};
+    uint32_t mActiveRequestTypeMask {0};
+    uint32_t mPausedRequestTypeMask {0};
+    uint64_t mNextListOrder {0};
+    uint64_t mGeneration {1};
+    uint64_t mCachedStatusGeneration {0};
+    std::string mCachedStatus;
+    std::vector<std::pair<uint64_t, uint64_t>> mSnapshotEntries;   //listOrder, entryId sorted by listOrder
+    uint64_t mSnapshotListOrderBound {0};
+    uint64_t mSnapshotGeneration {1};
+    uint64_t mStatusSequence {0};
+
+    void unindexApp(AppInfoList::iterator itApp);
+    static void countRequestType(unsigned int *count, uint32_t& mask, int requestTypeId, bool add);
+};
+
+//Focus state of every display indexed by displayId. It is sized once before any request
+//is served, the entries can neither be copied nor moved.
+using DisplayInfoTable = std::vector<DisplayFocusState>;
+
+#endif //DISPLAY_FOCUS_STATE_H_
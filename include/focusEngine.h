@@ -0,0 +1,93 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef FOCUS_ENGINE_H_
+#define FOCUS_ENGINE_H_
+
+#include <set>
+#include <string>
+#include <vector>
+#include <pbnjson.hpp>
+#include "focusTypes.h"
+#include "focusPolicy.h"
+#include "symbolTable.h"
+#include "displayFocusState.h"
+
+#define AF_FOCUS_HANDLE_DISPLAY_BITS 8
+
+/*
+ * Focus decisions of the service, without any IPC: the policy, the symbol table and the focus
+ * state of every display. It is built into the afpolicy library, which does not depend on
+ * luna-service2, so it can be embedded or driven directly by a benchmark.
+ * Requests, releases and cancels change the state and queue the events of the affected
+ * applications in an AppNotificationList, delivering them is left to the caller.
+ * A granted entry is identified by a focus handle, which is never 0.
+ */
+class FocusEngine
+{
+public:
+    explicit FocusEngine(int displayCount);
+
+    // Policy loading, as in FocusPolicy. Only before any request, use replacePolicy afterwards.
+    bool loadPolicyFromJson(const pbnjson::JValue& requestTypeArray)  { return mFocusPolicy.loadFromJson(requestTypeArray); }
+    bool loadPolicyFromImage(const POLICY_IMAGE_HEADER_T* image)      { return mFocusPolicy.loadFromImage(image); }
+    void loadDefaultPolicy()                                            { mFocusPolicy.loadDefault(); }
+    // Swaps in focusPolicy, which gets the previous policy, and re-evaluates the current entries
+    void replacePolicy(FocusPolicy& focusPolicy, AppNotificationList& notifications, std::set<int>& changedDisplays);
+    const FocusPolicy& getPolicy() const                                { return mFocusPolicy; }
+    const SymbolTable& getSymbolTable() const                           { return mSymbolTable; }
+
+    // The table is only resized before any request
+    void setDisplayCount(int displayCount);
+    int getDisplayCount() const                                         { return (int) mDisplayInfo.size(); }
+    bool validateDisplayId(int displayId) const;
+    DisplayFocusState& getDisplay(int displayId)                        { return mDisplayInfo[displayId]; }
+    const DisplayFocusState& getDisplay(int displayId) const            { return mDisplayInfo[displayId]; }
+
+    // result is AF_GRANTED, AF_GRANTEDALREADY or AF_CANNOTBEGRANTED, returns true when granted now
+    bool requestFocus(const int& displayId, const char* appId, int requestTypeId, const std::string& streamType,
+                      AppNotificationList& notifications, const char*& result, uint64_t& focusHandle);
+    // The entry is given by focusHandle, or else by streamType. Returns false if appId has no such entry,
+    // a streamType not held is not replaced by another entry of appId.
+    bool releaseFocus(const int& displayId, const char* appId, const std::string* streamType, uint64_t focusHandle,
+                      AppNotificationList& notifications);
+    // Removes the entries of focusHandles owned by appId, for an application gone away
+    void cancelFocus(const char* appId, const std::vector<uint64_t>& focusHandles, AppNotificationList& notifications,
+                     std::set<int>& changedDisplays);
+    // Current entry of focusHandle, nullptr once it is released or lost
+    const APP_INFO_T* getFocusEntry(uint64_t focusHandle);
+
+    static uint64_t makeFocusHandle(int displayId, uint64_t entryId);
+    static bool splitFocusHandle(uint64_t focusHandle, int& displayId, uint64_t& entryId);
+
+private:
+    FocusPolicy mFocusPolicy;
+    SymbolTable mSymbolTable;
+    DisplayInfoTable mDisplayInfo;
+
+    bool checkGrantedAlready(int applicationId, const int& displayId, int requestTypeId, uint64_t& focusHandle);
+    bool checkFeasibility(const int& displayId, int newRequestTypeId, AppNotificationList& notifications);
+    uint64_t updateDisplayActiveAppList(const int& displayId, int appId, int requestTypeId, int streamType);
+    void removeFocusEntry(const int& displayId, AppInfoList::iterator itApp, AppNotificationList& notifications);
+    bool pausedAppToActive(const int& displayId, int removedRequestTypeId, AppNotificationList& notifications);
+    bool isIncomingPairRequestTypeActive(int requestTypeId, const DisplayFocusState& displayInfo);
+    void reevaluateDisplayFocus(const int& displayId, AppNotificationList& notifications);
+    bool isMixedWithActive(int requestTypeId, uint32_t activeRequestTypeMask);
+};
+
+#endif //FOCUS_ENGINE_H_
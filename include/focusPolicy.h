@@ -0,0 +1,81 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef FOCUS_POLICY_H_
+#define FOCUS_POLICY_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <pbnjson.hpp>
+#include "focusTypes.h"
+#include "policyImage.h"
+
+/*
+ * Compiled form of audiofocuspolicy.json.
+ * Request types are numbered in the order they appear in the config file and
+ * every (active request type, incoming request type) pair is resolved to a
+ * FOCUS_ACTION_E once at load time, so focus decisions are plain array lookups.
+ * The outcome of a request for a given set of active and paused request types is
+ * memoized, so a repeated situation costs a single hash lookup.
+ * When no policy can be loaded the built-in DefaultFocusPolicy is used, its decisions
+ * come from StaticFocusDecision without the memo.
+ */
+class FocusPolicy
+{
+public:
+    FocusPolicy();
+
+    // Compile the "requestType" array of the policy config. Returns false if nothing usable was found.
+    bool loadFromJson(const pbnjson::JValue& requestTypeArray);
+    // Load a policy image checked by validatePolicyImage. Returns false if its records are not consistent.
+    bool loadFromImage(const POLICY_IMAGE_HEADER_T* image);
+    // Load the built-in copy of the shipped config
+    void loadDefault();
+    bool isDefault() const                                          { return mIsDefault; }
+    void clear();
+    void print() const;
+
+    int getRequestTypeId(const std::string& requestType) const;
+    int getRequestTypeId(const char* requestType, size_t length) const;
+    const std::string& getRequestTypeName(int requestTypeId) const;
+    int getRequestTypeCount() const                                 { return (int) mRequestTypes.size(); }
+    int getPriority(int requestTypeId) const                        { return mRequestTypes[requestTypeId].priority; }
+
+    FOCUS_ACTION_E getAction(int activeRequestTypeId, int incomingRequestTypeId) const
+                                     { return mActionTable[activeRequestTypeId][incomingRequestTypeId]; }
+
+    FEASIBILITY_OUTCOME_T getFeasibility(uint32_t activeRequestTypeMask, uint32_t pausedRequestTypeMask,
+                                         int incomingRequestTypeId) const;
+
+    static const char* actionToString(FOCUS_ACTION_E action);
+    static FOCUS_ACTION_E actionFromString(const std::string& action);
+
+private:
+    std::vector<REQUEST_TYPE_POLICY_INFO_T> mRequestTypes;
+    std::map<std::string, int> mRequestTypeIdMap;
+    FOCUS_ACTION_E mActionTable[AF_MAX_REQUEST_TYPES][AF_MAX_REQUEST_TYPES];
+    mutable std::unordered_map<uint64_t, FEASIBILITY_OUTCOME_T> mFeasibilityCache;
+    bool mIsDefault {false};
+
+    FEASIBILITY_OUTCOME_T computeFeasibility(uint32_t activeRequestTypeMask, uint32_t pausedRequestTypeMask,
+                                             int incomingRequestTypeId) const;
+};
+
+#endif //FOCUS_POLICY_H_
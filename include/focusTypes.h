@@ -0,0 +1,83 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef FOCUS_TYPES_H_
+#define FOCUS_TYPES_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Types of the focus engine. They are shared by the service and by the afpolicy library,
+ * which does not depend on luna-service2.
+ */
+
+#define AF_MAX_REQUEST_TYPES 16
+#define AF_INVALID_REQUEST_TYPE -1
+
+typedef enum FocusAction
+{
+    eFocusActionNone = 0,
+    eFocusActionMix,
+    eFocusActionPause,
+    eFocusActionLost
+}FOCUS_ACTION_E;
+
+typedef struct RequestTypePolicyInfo
+{
+    std::string requestType;
+    int priority {-1};
+}REQUEST_TYPE_POLICY_INFO_T;
+
+//appId and streamType are SymbolTable ids, requestTypeId is a FocusPolicy id
+typedef struct AppInfo
+{
+    int appId {-1};
+    int requestTypeId {AF_INVALID_REQUEST_TYPE};
+    int streamType {-1};
+    bool isPaused {false};
+    uint64_t listOrder {0};         //insertion stamp, list order is the order of this stamp
+    uint64_t entryId {0};           //stamp of the first insertion, kept while the entry moves between lists
+}APP_INFO_T;
+
+typedef struct FeasibilityOutcome
+{
+    bool granted {true};
+    uint32_t pauseMask {0};         //active request types to be moved to the paused list
+    uint32_t lostActiveMask {0};    //active request types to be removed with AF_LOST
+    uint32_t lostPausedMask {0};    //paused request types to be removed with AF_LOST
+}FEASIBILITY_OUTCOME_T;
+
+/*
+ * Event to be sent to an application as the result of a focus decision, about the entry of focusHandle.
+ * operation tells the adapter what to do with the entry: 's' send, 'n' send and forget it, 'r' forget it.
+ */
+typedef struct AppNotification
+{
+    int appId;
+    const char *event;
+    char operation;
+    uint64_t focusHandle;
+}APP_NOTIFICATION_T;
+
+typedef std::vector<APP_NOTIFICATION_T> AppNotificationList;
+
+#define REQUEST_TYPE_BIT(requestTypeId) (1u << (requestTypeId))
+
+#endif //FOCUS_TYPES_H_
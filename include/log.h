@@ -19,8 +19,39 @@
 #ifndef LOG_H_
 #define LOG_H_
 
+#define INIT_KVCOUNT                0
+
+#if defined(AF_LOG_TO_STDERR)
+
+/*
+ * Host tools built from the policy sources, like afpolicyc, do not depend on PmLog:
+ * the messages of these sources go to stderr.
+ */
+#include <cstdio>
+#include <cstdarg>
+
+static inline void afLogToStderr(const char* level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+static inline void afLogToStderr(const char* level, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "afpolicy: %s: ", level);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+#define PM_LOG_CRITICAL(msgid, kvcount, ...)  afLogToStderr("critical", __VA_ARGS__)
+#define PM_LOG_ERROR(msgid, kvcount, ...)     afLogToStderr("error", __VA_ARGS__)
+#define PM_LOG_WARNING(msgid, kvcount, ...)   afLogToStderr("warning", __VA_ARGS__)
+#define PM_LOG_INFO(msgid, kvcount, ...)      afLogToStderr("info", __VA_ARGS__)
+#define PM_LOG_DEBUG(...)                     afLogToStderr("debug", __VA_ARGS__)
+
+#else
+
 #include <PmLogLib.h>
 #include <glib.h>
+#include <atomic>
 
 //get Audio focus manager pm log context
 PmLogContext getPmLogContext();
@@ -30,13 +61,55 @@ PmLogErr setPmLogContext(const char* logContextName);
 
 //This is for PmLog implementation
 extern PmLogContext audioFocusMgrLogContext;
-#define INIT_KVCOUNT                0
 
-#define PM_LOG_CRITICAL(msgid, kvcount, ...)  PmLogCritical(getPmLogContext(), msgid, kvcount, ##__VA_ARGS__)
-#define PM_LOG_ERROR(msgid, kvcount, ...)     PmLogError(getPmLogContext(), msgid, kvcount, ##__VA_ARGS__)
-#define PM_LOG_WARNING(msgid, kvcount, ...)   PmLogWarning(getPmLogContext(), msgid, kvcount, ##__VA_ARGS__)
-#define PM_LOG_INFO(msgid, kvcount, ...)      PmLogInfo(getPmLogContext(), msgid, kvcount, ##__VA_ARGS__)
-#define PM_LOG_DEBUG(...)                     PmLogDebug(getPmLogContext(), ##__VA_ARGS__)
+//Lowest level compiled in, release builds can set it to drop the INFO and DEBUG logs altogether
+#ifndef AF_LOG_MIN_LEVEL
+#define AF_LOG_MIN_LEVEL                      kPmLogLevel_Debug
+#endif
+
+//Level of the context as last read from PmLog, so a log site does not query PmLog.
+//refreshPmLogLevel reads it again: the log writer does so after emitting messages, which
+//applies a lowered level, and the service on SIGHUP, which applies a raised one.
+extern std::atomic<int> audioFocusMgrLogLevel;
+void refreshPmLogLevel();
+
+static inline bool isPmLogLevelEnabled(int level)
+{
+    return level <= audioFocusMgrLogLevel.load(std::memory_order_relaxed);
+}
+
+//The level is checked first, arguments are only evaluated when the message is going to be logged.
+//Code building data only for a log can be guarded with AF_LOG_ENABLED as well.
+#define AF_LOG_ENABLED(level)                 ((level) <= AF_LOG_MIN_LEVEL && isPmLogLevelEnabled(level))
+
+/*
+ * Asynchronous backend: once started, the caller stores the format and a copy of its arguments
+ * into a slot of a preallocated ring and a background thread formats them and hands them to
+ * PmLog, so neither formatting nor PmLog I/O runs on the main loop. The format has to be a
+ * string literal. When the ring is full the message is dropped and counted, the thread reports
+ * the count. CRITICAL messages always go to PmLog directly.
+ */
+bool startAsyncLog();
+void stopAsyncLog();
+bool isAsyncLogRunning();
+void asyncLogWrite(int level, const char* msgid, const char* format, ...) G_GNUC_PRINTF(3, 4);
+
+#define PM_LOG_CRITICAL(msgid, kvcount, ...)  (AF_LOG_ENABLED(kPmLogLevel_Critical) ? \
+                                               (void) PmLogCritical(getPmLogContext(), msgid, kvcount, ##__VA_ARGS__) : (void) 0)
+#define PM_LOG_ERROR(msgid, kvcount, ...)     (AF_LOG_ENABLED(kPmLogLevel_Error) ? (isAsyncLogRunning() ? \
+                                               asyncLogWrite(kPmLogLevel_Error, msgid, ##__VA_ARGS__) : \
+                                               (void) PmLogError(getPmLogContext(), msgid, kvcount, ##__VA_ARGS__)) : (void) 0)
+#define PM_LOG_WARNING(msgid, kvcount, ...)   (AF_LOG_ENABLED(kPmLogLevel_Warning) ? (isAsyncLogRunning() ? \
+                                               asyncLogWrite(kPmLogLevel_Warning, msgid, ##__VA_ARGS__) : \
+                                               (void) PmLogWarning(getPmLogContext(), msgid, kvcount, ##__VA_ARGS__)) : (void) 0)
+#define PM_LOG_INFO(msgid, kvcount, ...)      (AF_LOG_ENABLED(kPmLogLevel_Info) ? (isAsyncLogRunning() ? \
+                                               asyncLogWrite(kPmLogLevel_Info, msgid, ##__VA_ARGS__) : \
+                                               (void) PmLogInfo(getPmLogContext(), msgid, kvcount, ##__VA_ARGS__)) : (void) 0)
+#define PM_LOG_DEBUG(...)                     (AF_LOG_ENABLED(kPmLogLevel_Debug) ? (isAsyncLogRunning() ? \
+                                               asyncLogWrite(kPmLogLevel_Debug, NULL, ##__VA_ARGS__) : \
+                                               (void) PmLogDebug(getPmLogContext(), ##__VA_ARGS__)) : (void) 0)
+
+#endif //AF_LOG_TO_STDERR
 
 //If log level is higher than DEBUG(lowest), you need to use Message ID.
 //Start up and shutdown message ID's
@@ -24,6 +24,7 @@
 #include <pbnjson.h>
 #include <pbnjson.hpp>
 #include "common.h"
+#include <string>
 /*
  * Helper macros to build schemas in a more reliable, readable & editable way in C++
  */
@@ -48,6 +49,7 @@
 
 
 #define PROP(name, type)                                 "\"" #name "\":{\"type\":\"" #type "\"}"
+#define PROP_ARRAY(name, items)                          "\"" #name "\":{\"type\":\"array\",\"items\":" items "}"
 #define PROP_WITH_VAL_1(name, type, v1)                  "\"" #name "\":{\"type\":\"" #type "\", \"enum\": [" #v1 "]}"
 
 #define REQUIRED_1(p1)                                   ",\"required\":[\"" #p1 "\"]"
@@ -85,6 +87,12 @@
 #define REQUIRED(name, type) "\"" #name "\":{\"type\":\"" #type "\"}"
 #define OPTIONAL(name, type) "\"" #name "\":{\"type\":\"" #type "\",\"optional\":true}"
 
+/*
+ * Returns the compiled form of a schema. Schemas are compiled once per schema text
+ * and kept for the life of the process, so message parsing never compiles a schema.
+ */
+const pbnjson::JSchema & getCachedSchema(const char * schema);
+
 /*
  * Helper class to parse a json message using a schema (if specified)
  */
@@ -102,7 +110,7 @@ public:
 
 private:
     const char *                mJson;
-    pbnjson::JSchemaFragment    mSchema;
+    const pbnjson::JSchema &    mSchema;
     pbnjson::JDomParser            mParser;
 };
 
@@ -139,17 +147,69 @@ public:
 private:
     LSMessage *                    mMessage;
     const char *                mSchemaText;
-    pbnjson::JSchemaFragment    mSchema;
+    const pbnjson::JSchema &    mSchema;
     pbnjson::JDomParser            mParser;
 
 };
 
+/*
+ * Fast path for the small, flat payloads of requestFocus and releaseFocus.
+ * The payload is validated and the values are extracted in place, without DOM and
+ * without heap allocation. Anything unusual (unknown or duplicate key, escaped or
+ * non ASCII string, non integer number, nested value...) is left to
+ * LSMessageJsonParser, so that error replies stay the same.
+ */
+#define FOCUS_PARAM_REQUEST_TYPE    (1u << 0)
+#define FOCUS_PARAM_DISPLAY_ID      (1u << 1)
+#define FOCUS_PARAM_SUBSCRIBE       (1u << 2)
+#define FOCUS_PARAM_STREAM_TYPE     (1u << 3)
+#define FOCUS_PARAM_FOCUS_HANDLE    (1u << 4)
+
+// Non owning view on a string, either in the message payload or in the fallback storage
+typedef struct JsonStringView
+{
+    const char * data {""};
+    size_t length {0};
+    std::string str() const                     { return std::string(data, length); }
+}JSON_STRING_VIEW_T;
+
+typedef struct FocusRequestParams
+{
+    unsigned int presentParams {0};
+    JSON_STRING_VIEW_T requestType;
+    JSON_STRING_VIEW_T streamType;
+    int displayId {-1};
+    bool subscribe {false};
+    uint64_t focusHandle {0};
+    //Only used when the payload goes through LSMessageJsonParser
+    std::string requestTypeStorage;
+    std::string streamTypeStorage;
+}FOCUS_REQUEST_PARAMS_T;
+
+// Fast path only, returns false if the payload has to go through the regular parser
+bool parseFocusRequestPayload(const char * payload, unsigned int allowedParams, unsigned int requiredParams,
+                              FOCUS_REQUEST_PARAMS_T & params);
+
+// Values of a payload validated by LSMessageJsonParser, the regular path of parseFocusRequestMessage
+void readFocusRequestParams(const pbnjson::JValue & payload, unsigned int allowedParams, FOCUS_REQUEST_PARAMS_T & params);
+
+// Fast path, falling back to LSMessageJsonParser with schema. Replies to the sender on schema errors.
+bool parseFocusRequestMessage(LSHandle * sender, LSMessage * message, const char * schema, unsigned int allowedParams,
+                              unsigned int requiredParams, const char * callerFunction, FOCUS_REQUEST_PARAMS_T & params);
+
 // build a standard reply returnValue & errorCode/errorText if defined
 pbnjson::JValue createJsonReply(bool returnValue = true, int errorCode = 0, const char * errorText = 0);
 
 // build a standard json reply string without the overhead of using json schema
 std::string createJsonReplyString(bool returnValue = true, int errorCode = 0, const char * errorText = 0);
 
+// append value to out as a quoted json string, escaping where needed
+std::string & appendJsonString(std::string & out, const char * value, size_t length);
+inline std::string & appendJsonString(std::string & out, const std::string & value)
+{
+    return appendJsonString(out, value.data(), value.length());
+}
+
 // serialize a reply
 std::string jsonToString(pbnjson::JValue & reply, const char * schema = SCHEMA_ANY);
 
@@ -0,0 +1,82 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef POLICY_IMAGE_H_
+#define POLICY_IMAGE_H_
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <pbnjson.hpp>
+#include "focusTypes.h"
+
+/*
+ * Binary form of audiofocuspolicy.json, written by afpolicyc and mapped by the service
+ * at startup instead of parsing the json.
+ * The image is a header followed by one record per request type, in request type id order.
+ * It is in host byte order: an image from a host of the other byte order fails the magic check.
+ * sourceSize is the size of the json the image was compiled from. The image is stale, and the
+ * json is loaded instead, once the json has another size or is newer than the image, so the
+ * check at startup costs a stat and not a read of the json.
+ */
+#define AF_POLICY_IMAGE_MAGIC 0x4c504641                //"AFPL"
+#define AF_POLICY_IMAGE_VERSION 2
+#define AF_POLICY_IMAGE_FILE "audiofocuspolicy.bin"
+#define AF_POLICY_IMAGE_NAME_SIZE 48
+#define AF_POLICY_IMAGE_OPTION_UNSET -1
+#define AF_POLICY_IMAGE_OPTION_INVALID INT32_MIN
+
+//Optional keys of the json next to "requestType", carried over into the image
+#define AF_CONFIG_BROADCAST_COALESCE_MS "broadcastCoalesceMs"
+#define AF_CONFIG_DISPLAY_COUNT "displayCount"
+#define AF_MAX_BROADCAST_COALESCE_MS 1000
+#define AF_MAX_DISPLAY_COUNT 256                        //displayIds a focus handle can carry
+
+typedef struct PolicyImageHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                      //header and records
+    uint32_t checksum;                  //policyImageChecksum of everything after this field
+    uint64_t sourceSize;
+    int32_t broadcastCoalesceMs;        //AF_POLICY_IMAGE_OPTION_UNSET when not in the json
+    int32_t displayCount;               //AF_POLICY_IMAGE_OPTION_UNSET when not in the json
+    uint32_t requestTypeCount;
+    uint32_t reserved;
+}POLICY_IMAGE_HEADER_T;
+
+typedef struct PolicyImageRequestType
+{
+    char name[AF_POLICY_IMAGE_NAME_SIZE];           //nul terminated
+    int32_t priority;
+    uint8_t actions[AF_MAX_REQUEST_TYPES];          //FOCUS_ACTION_E for each incoming request type id
+}POLICY_IMAGE_REQUEST_TYPE_T;
+
+class FocusPolicy;
+
+uint32_t policyImageChecksum(const void *data, size_t length);
+
+// Optional keys of config: AF_POLICY_IMAGE_OPTION_UNSET if absent, AF_POLICY_IMAGE_OPTION_INVALID if not a number
+void readPolicyConfigOptions(const pbnjson::JValue& config, int32_t& broadcastCoalesceMs, int32_t& displayCount);
+// Serializes policy, false if it cannot be represented in an image
+bool buildPolicyImage(const FocusPolicy& policy, uint64_t sourceSize, int32_t broadcastCoalesceMs,
+                      int32_t displayCount, std::string& image);
+// Header of a well formed image of this version, nullptr otherwise
+const POLICY_IMAGE_HEADER_T* validatePolicyImage(const void *data, size_t size);
+
+#endif //POLICY_IMAGE_H_
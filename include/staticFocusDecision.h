@@ -0,0 +1,87 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef STATIC_FOCUS_DECISION_H_
+#define STATIC_FOCUS_DECISION_H_
+
+#include <cstdint>
+#include "focusTypes.h"
+
+//Request types whose entry for an incoming request type is none, pause or lost, one set per incoming request type
+typedef struct ActionMasks
+{
+    uint32_t none[AF_MAX_REQUEST_TYPES];
+    uint32_t pause[AF_MAX_REQUEST_TYPES];
+    uint32_t lost[AF_MAX_REQUEST_TYPES];
+}ACTION_MASKS_T;
+
+template <typename Policy>
+constexpr ACTION_MASKS_T buildActionMasks()
+{
+    ACTION_MASKS_T masks {};
+    for (int incoming = 0; incoming < Policy::requestTypeCount; incoming++)
+    {
+        for (int active = 0; active < Policy::requestTypeCount; active++)
+        {
+            FOCUS_ACTION_E action = Policy::getAction(active, incoming);
+            if (eFocusActionNone == action)
+                masks.none[incoming] |= REQUEST_TYPE_BIT(active);
+            else if (eFocusActionPause == action)
+                masks.pause[incoming] |= REQUEST_TYPE_BIT(active);
+            else if (eFocusActionLost == action)
+                masks.lost[incoming] |= REQUEST_TYPE_BIT(active);
+        }
+    }
+    return masks;
+}
+
+/*
+ * Focus decisions of a policy known at compile time, such as DefaultFocusPolicy.
+ * Policy provides requestTypeCount and a constexpr getAction(active, incoming). The action
+ * table is folded into three masks per incoming request type, so a decision is a few
+ * and/or operations with no loop, branch or cache, and gives the same outcome as
+ * FocusPolicy::computeFeasibility.
+ */
+template <typename Policy>
+class StaticFocusDecision
+{
+public:
+    static_assert(Policy::requestTypeCount > 0 && Policy::requestTypeCount <= AF_MAX_REQUEST_TYPES,
+                  "invalid number of request types");
+
+    static constexpr FEASIBILITY_OUTCOME_T getFeasibility(uint32_t activeRequestTypeMask, uint32_t pausedRequestTypeMask,
+                                                          int incomingRequestTypeId)
+    {
+        //All ones when no active request type refuses the incoming one, zero otherwise
+        uint32_t granted = 0u - (uint32_t) !(activeRequestTypeMask & mActionMasks.none[incomingRequestTypeId]);
+        FEASIBILITY_OUTCOME_T outcome;
+        outcome.granted = granted != 0;
+        outcome.pauseMask = activeRequestTypeMask & mActionMasks.pause[incomingRequestTypeId] & granted;
+        outcome.lostActiveMask = activeRequestTypeMask & mActionMasks.lost[incomingRequestTypeId] & granted;
+        outcome.lostPausedMask = pausedRequestTypeMask & mActionMasks.lost[incomingRequestTypeId] & granted;
+        return outcome;
+    }
+
+private:
+    static constexpr ACTION_MASKS_T mActionMasks = buildActionMasks<Policy>();
+};
+
+template <typename Policy>
+constexpr ACTION_MASKS_T StaticFocusDecision<Policy>::mActionMasks;
+
+#endif //STATIC_FOCUS_DECISION_H_
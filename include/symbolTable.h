@@ -0,0 +1,48 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SYMBOL_TABLE_H_
+#define SYMBOL_TABLE_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#define AF_INVALID_SYMBOL -1
+
+/*
+ * Interns strings such as appId and streamType into small integer ids, so that
+ * focus state only stores and compares integers. Ids are never recycled: the set
+ * of application ids and stream types seen by the service is bounded.
+ */
+class SymbolTable
+{
+public:
+    // Returns the id of name, adding it to the table if needed
+    int intern(const std::string& name);
+    // Returns the id of name, or AF_INVALID_SYMBOL if it was never interned
+    int find(const std::string& name) const;
+    const std::string& getName(int symbolId) const;
+    int size() const                                        { return (int) mSymbolNames.size(); }
+
+private:
+    std::unordered_map<std::string, int> mSymbolIdMap;
+    std::vector<const std::string*> mSymbolNames;
+};
+
+#endif //SYMBOL_TABLE_H_
@@ -17,6 +17,31 @@
 * LICENSE@@@ */
 
 #include <audioFocusManager.h>
+#include <algorithm>
+#include <glib-unix.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define AF_FOCUS_RESULT_REPLY(result) \
+    "{\"returnValue\":true,\"subscribed\":true,\"result\":\"" result "\"}"
+//Any of the replies below with a focusHandle appended
+#define AF_FOCUS_HANDLE_REPLY_SIZE 128
+
+static const AF_FOCUS_RESULT_REPLY_T focusResultReplies[] =
+{
+    {"AF_GRANTED", AF_FOCUS_RESULT_REPLY("AF_GRANTED")},
+    {"AF_PAUSE", AF_FOCUS_RESULT_REPLY("AF_PAUSE")},
+    {"AF_LOST", AF_FOCUS_RESULT_REPLY("AF_LOST")},
+    {"AF_GRANTEDALREADY", AF_FOCUS_RESULT_REPLY("AF_GRANTEDALREADY")},
+    {"AF_CANNOTBEGRANTED", AF_FOCUS_RESULT_REPLY("AF_CANNOTBEGRANTED")},
+    //Release is not a subscription reply
+    {"AF_SUCCESSFULLY_RELEASED", "{\"returnValue\":true,\"result\":\"AF_SUCCESSFULLY_RELEASED\"}"}
+};
 
 LSHandle *AudioFocusManager::mServiceHandle;
 
@@ -24,13 +49,17 @@ LSMethod AudioFocusManager::rootMethod[] = {
     {"requestFocus", AudioFocusManager::_requestFocus},
     {"releaseFocus", AudioFocusManager::_releaseFocus},
     {"getStatus", AudioFocusManager::_getStatus},
+    {"requestFocusBatch", AudioFocusManager::_requestFocusBatch},
+    {"releaseFocusBatch", AudioFocusManager::_releaseFocusBatch},
     {0, 0}
 };
 
 AudioFocusManager *AudioFocusManager::AFService = NULL;
 
-AudioFocusManager::AudioFocusManager()
+AudioFocusManager::AudioFocusManager() : mFocusEngine(AF_DEFAULT_DISPLAY_COUNT)
 {
+    //A version kept by a client across a restart of the service must not match a new one
+    mStatusVersionEpoch = (uint64_t) g_random_int_range(1, AF_STATUS_VERSION_EPOCH_RANGE);
     PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "AudioFocusManager Constructor invoked");
 }
 
@@ -73,6 +102,22 @@ void AudioFocusManager::deleteInstance()
     return;
 }
 
+AudioFocusManager::~AudioFocusManager()
+{
+    if (mBroadcastSourceId)
+        g_source_remove(mBroadcastSourceId);
+    if (mPolicyReloadSourceId)
+        g_source_remove(mPolicyReloadSourceId);
+    if (mPolicyWatchSourceId)
+        g_source_remove(mPolicyWatchSourceId);
+    if (mPolicyWatchFd >= 0)
+        close(mPolicyWatchFd);
+    for (auto& focusSubscription : mFocusSubscriptions)
+        LSMessageUnref(focusSubscription.first);
+    mFocusSubscriptions.clear();
+    mHandleSubscriptions.clear();
+}
+
 /*
 Functionality of this method:
 ->Initializes the service registration.
@@ -87,11 +132,14 @@ bool AudioFocusManager::init(GMainLoop *mainLoop)
         return false;
     }
 
+    //Without a usable config the service still runs with the built-in policy, a fixed file is then hot reloaded
     if(loadRequestPolicyJsonConfig() == false)
     {
-        PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "Failed to parse RequestPolicy Json config");
-        return false;
+        PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "Failed to parse RequestPolicy Json config, using the built-in policy");
+        mFocusEngine.loadDefaultPolicy();
+        applyConfigOptions(AF_POLICY_IMAGE_OPTION_UNSET, AF_POLICY_IMAGE_OPTION_UNSET);
     }
+    watchRequestPolicyConfig();
 #if defined(WEBOS_SOC_AUTO)
     bool retVal = LSRegisterServerStatusEx(GetLSService(), ACCOUNT_SERVICE, serviceStatusCallBack, this, nullptr, nullptr);
     if (!retVal)
@@ -107,10 +155,8 @@ bool AudioFocusManager::init(GMainLoop *mainLoop)
  * Functionality of this method:
  * ->Load the RequestPolicy JSON config and populate internal structure for request info
  */
-bool AudioFocusManager::loadRequestPolicyJsonConfig()
+static pbnjson::JValue readRequestPolicyJsonConfig()
 {
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"loadRequestPolicyJsonConfig");
-
     std::stringstream jsonFilePath;
     jsonFilePath << CONFIG_DIR_PATH << "/" << REQUEST_TYPE_POLICY_CONFIG;
     PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "Loading request types policy info from json file %s",\
@@ -121,45 +167,189 @@ bool AudioFocusManager::loadRequestPolicyJsonConfig()
     if (!fileJsonRequestPolicyConfig.isValid() || !fileJsonRequestPolicyConfig.isObject())
     {
         PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "Failed to parse json config file, using defaults. File: %s", jsonFilePath.str().c_str());
+        return pbnjson::JValue();
+    }
+    return fileJsonRequestPolicyConfig;
+}
+
+bool AudioFocusManager::loadRequestPolicyJsonConfig()
+{
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"loadRequestPolicyJsonConfig");
+    if (loadRequestPolicyImage())
+        return true;
+
+    pbnjson::JValue fileJsonRequestPolicyConfig = readRequestPolicyJsonConfig();
+    if (!fileJsonRequestPolicyConfig.isObject())
+        return false;
+
+    if (!mFocusEngine.loadPolicyFromJson(fileJsonRequestPolicyConfig["requestType"]))
+    {
+        PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "No valid request type found in config file");
         return false;
     }
 
-    pbnjson::JValue policyInfo = fileJsonRequestPolicyConfig["requestType"];
-    if (!policyInfo.isArray())
+    int32_t broadcastCoalesceMs = AF_POLICY_IMAGE_OPTION_UNSET;
+    int32_t displayCount = AF_POLICY_IMAGE_OPTION_UNSET;
+    readPolicyConfigOptions(fileJsonRequestPolicyConfig, broadcastCoalesceMs, displayCount);
+    applyConfigOptions(broadcastCoalesceMs, displayCount);
+    return true;
+}
+
+/*
+ * Functionality of this method:
+ * ->Loads the policy image compiled by afpolicyc, so the json is not parsed at startup.
+ * ->The image is not used if it is corrupt, of another version, or if the json has another size
+ *   than the one it was compiled from or is newer than it. Without the json the image is used
+ *   as it is.
+ */
+bool AudioFocusManager::loadRequestPolicyImage()
+{
+    std::stringstream imageFilePath;
+    imageFilePath << CONFIG_DIR_PATH << "/" << AF_POLICY_IMAGE_FILE;
+    int fd = open(imageFilePath.str().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
     {
-        PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "request policyInfo is not an array");
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "No policy image %s, loading the json config", imageFilePath.str().c_str());
         return false;
     }
+    struct stat imageStat;
+    void *image = MAP_FAILED;
+    if (fstat(fd, &imageStat) == 0 && imageStat.st_size > 0)
+        image = mmap(NULL, (size_t) imageStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED)
+    {
+        PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "Cannot map policy image %s", imageFilePath.str().c_str());
+        return false;
+    }
+
+    bool loaded = false;
+    std::stringstream jsonFilePath;
+    jsonFilePath << CONFIG_DIR_PATH << "/" << REQUEST_TYPE_POLICY_CONFIG;
+    struct stat jsonStat;
+    const POLICY_IMAGE_HEADER_T *header = validatePolicyImage(image, (size_t) imageStat.st_size);
+    if (!header)
+        PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "Invalid policy image %s", imageFilePath.str().c_str());
+    else if (stat(jsonFilePath.str().c_str(), &jsonStat) == 0 && ((uint64_t) jsonStat.st_size != header->sourceSize || \
+        jsonStat.st_mtime > imageStat.st_mtime))
+        PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "Policy image %s is stale", imageFilePath.str().c_str());
+    else if (mFocusEngine.loadPolicyFromImage(header))
+    {
+        applyConfigOptions(header->broadcastCoalesceMs, header->displayCount);
+        loaded = true;
+    }
+    munmap(image, (size_t) imageStat.st_size);
+    if (loaded)
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "Loaded policy image %s", imageFilePath.str().c_str());
+    return loaded;
+}
 
-    for (const pbnjson::JValue& elements : policyInfo.items())
+//Options read from the json or from the policy image, AF_POLICY_IMAGE_OPTION_UNSET keeps the default
+void AudioFocusManager::applyConfigOptions(int32_t broadcastCoalesceMs, int32_t displayCount)
+{
+    //Optional window to gather status broadcasts, by default they go out once the current event is handled
+    if (broadcastCoalesceMs != AF_POLICY_IMAGE_OPTION_UNSET)
     {
-        REQUEST_TYPE_POLICY_INFO_T stPolicyInfo;
-        std::string requestType;
-        int priority;
-        if (elements["request"].asString(requestType) == CONV_OK)
-        {
-            stPolicyInfo.priority = elements["priority"].asNumber<int>();
-            pbnjson::JValue incomingRequestInfo = elements["incoming"];
-            if (incomingRequestInfo.isArray())
-                stPolicyInfo.incomingRequestInfo = incomingRequestInfo;
-            mAFRequestPolicyInfo[requestType] = stPolicyInfo;
-        }
+        if (broadcastCoalesceMs >= 0 && broadcastCoalesceMs <= AF_MAX_BROADCAST_COALESCE_MS)
+            mBroadcastCoalesceMs = (guint) broadcastCoalesceMs;
         else
-        {
-            PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, \
-                "loadRequestPolicyJsonConfig: Invalid request type entry in config file, skipping");
-            continue;
-        }
+            PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "Invalid %s in config file, broadcasts are not delayed", \
+                AF_CONFIG_BROADCAST_COALESCE_MS);
     }
-    return true;
+
+    //Optional number of displays, the table is sized here once before any request is served
+    if (displayCount != AF_POLICY_IMAGE_OPTION_UNSET)
+    {
+        if (displayCount > 0 && displayCount <= AF_MAX_DISPLAY_COUNT)
+            mFocusEngine.setDisplayCount(displayCount);
+        else
+            PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "Invalid %s in config file, using %d displays", \
+                AF_CONFIG_DISPLAY_COUNT, mFocusEngine.getDisplayCount());
+    }
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "Focus state kept for %d displays", mFocusEngine.getDisplayCount());
 }
 
 void AudioFocusManager::printRequestPolicyJsonInfo()
 {
     PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"printRequestPolicyJsonInfo");
-    for (auto& it : mAFRequestPolicyInfo)
-        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "RequestType: %s  Priority: %d incomingRequestInfo: %s", it.first.c_str(), \
-            it.second.priority, it.second.incomingRequestInfo.stringify().c_str());
+    mFocusEngine.getPolicy().print();
+}
+
+/*
+ * Functionality of this method:
+ * ->Watches the config directory, editors often replace the file instead of writing to it.
+ * ->Without the watch the service keeps working, the policy is then only loaded at startup.
+ */
+void AudioFocusManager::watchRequestPolicyConfig()
+{
+    mPolicyWatchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mPolicyWatchFd < 0)
+    {
+        PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "watchRequestPolicyConfig: inotify_init1 failed, errno: %d", errno);
+        return;
+    }
+    if (inotify_add_watch(mPolicyWatchFd, CONFIG_DIR_PATH, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "watchRequestPolicyConfig: cannot watch %s, errno: %d", \
+            CONFIG_DIR_PATH, errno);
+        close(mPolicyWatchFd);
+        mPolicyWatchFd = -1;
+        return;
+    }
+    mPolicyWatchSourceId = g_unix_fd_add(mPolicyWatchFd, G_IO_IN, AudioFocusManager::_requestPolicyConfigChanged, this);
+}
+
+//A burst of writes gives a single reload once the file has settled
+gboolean AudioFocusManager::requestPolicyConfigChanged(gint fd, GIOCondition condition)
+{
+    char buffer[sizeof(struct inotify_event) + NAME_MAX + 1] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool policyChanged = false;
+    ssize_t length = 0;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *event = buffer; event < buffer + length; )
+        {
+            const struct inotify_event *inotifyEvent = (const struct inotify_event *) event;
+            if (inotifyEvent->len && strcmp(inotifyEvent->name, REQUEST_TYPE_POLICY_CONFIG) == 0)
+                policyChanged = true;
+            event += sizeof(struct inotify_event) + inotifyEvent->len;
+        }
+    }
+    if (policyChanged)
+    {
+        if (mPolicyReloadSourceId)
+            g_source_remove(mPolicyReloadSourceId);
+        mPolicyReloadSourceId = g_timeout_add(AF_POLICY_RELOAD_DELAY_MS, AudioFocusManager::_reloadRequestPolicy, this);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+/*
+ * Functionality of this method:
+ * ->Compiles the changed config into a new policy, the live one is kept if it is not valid.
+ * ->Once swapped in by the focus engine, the entries take the ids of their request type in the new policy.
+ *   Entries of a request type the new policy no longer has are lost, the other ones are
+ *   re-evaluated against the new action table.
+ */
+bool AudioFocusManager::reloadRequestPolicy()
+{
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "reloadRequestPolicy");
+    pbnjson::JValue fileJsonRequestPolicyConfig = readRequestPolicyJsonConfig();
+    FocusPolicy focusPolicy;
+    if (!fileJsonRequestPolicyConfig.isObject() || !focusPolicy.loadFromJson(fileJsonRequestPolicyConfig["requestType"]))
+    {
+        PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "reloadRequestPolicy: invalid config, the current policy is kept");
+        return false;
+    }
+
+    AppNotificationList notifications;
+    std::set<int> changedDisplays;
+    mFocusEngine.replacePolicy(focusPolicy, notifications, changedDisplays);
+    printRequestPolicyJsonInfo();
+    for (int displayId : changedDisplays)
+        scheduleStatusBroadcast(displayId);
+    manageAppSubscription(notifications);
+    return true;
 }
 
 /*
@@ -209,47 +399,25 @@ bool AudioFocusManager::cancelFunction(LSHandle *sh, LSMessage *message, void *d
         appId = LSMessageGetSenderServiceName(message);
     }
     PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "Subscription cancelled from app %s", appId);
-    if((method != NULL) && strcmp(method, AF_API_REQUEST_FOCUS) == 0)
+    if((method != NULL) && (appId != NULL) && (strcmp(method, AF_API_REQUEST_FOCUS) == 0 || \
+        strcmp(method, AF_API_REQUEST_FOCUS_BATCH) == 0))
     {
-        int displayId = -1;
-#if defined(WEBOS_SOC_AUTO)
-        std::string sessionInfo = LSMessageGetSessionId(message);
-        displayId = getSessionDisplayId(sessionInfo);
-#else
-        msg.get("displayId", displayId);
-#endif
-        auto itDisplay = mDisplayInfoMap.find(displayId);
-        if (itDisplay == mDisplayInfoMap.end())
-        {
-            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: New display entry for:%d Request feasible", displayId);
+        int appIdSymbol = mFocusEngine.getSymbolTable().find(appId);
+        if (appIdSymbol == AF_INVALID_SYMBOL)
             return true;
-        }
-        DISPLAY_INFO_T& displayInfo = itDisplay->second;
-        for (auto itPaused = displayInfo.pausedAppList.begin(); \
-            itPaused != displayInfo.pausedAppList.end(); itPaused++)
-        {
-            if ((appId != NULL) && appId == itPaused->appId)
-            {
-                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "Paused app Killed, remove from list %s Request type: %s", \
-                    appId, itPaused->requestType.c_str());
-                displayInfo.pausedAppList.erase(itPaused--);
-                broadcastStatusToSubscribers(displayId);
-                return true;
-            }
-        }
-        for (auto itActive = displayInfo.activeAppList.begin(); itActive != displayInfo.activeAppList.end(); itActive++)
-        {
-            if (itActive->appId == appId)
-            {
-                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"Active app Killed: Removing appId: %s Request type: %s", \
-                    appId, itActive->requestType.c_str());
-                std::string requestType = itActive->requestType;
-                displayInfo.activeAppList.erase(itActive--);
-                pausedAppToActive(displayInfo, requestType);
-                broadcastStatusToSubscribers(displayId);
-                return true;
-            }
-        }
+        //Only the entries granted with this subscription are removed, other requests of the app stay
+        std::vector<uint64_t> focusHandles;
+        auto itSubscription = mFocusSubscriptions.find(message);
+        if (itSubscription != mFocusSubscriptions.end())
+            focusHandles = itSubscription->second.focusHandles;
+        //The bus already dropped the message from AF_SUBSCRIPTION_LIST
+        removeFocusSubscription(message);
+        AppNotificationList notifications;
+        std::set<int> changedDisplays;
+        mFocusEngine.cancelFocus(appId, focusHandles, notifications, changedDisplays);
+        manageAppSubscription(notifications);
+        for (int displayId : changedDisplays)
+            scheduleStatusBroadcast(displayId);
     }
     return true;
 }
@@ -264,38 +432,29 @@ bool AudioFocusManager::requestFocus(LSHandle *sh, LSMessage *message, void *dat
 {
     PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"requestFocus");
     int displayId = -1;
-    std::string requestName;
-    std::string reply;
-    bool subscription;
-    std::string streamType;
+    FOCUS_REQUEST_PARAMS_T params;
 #if defined(WEBOS_SOC_AUTO)
-    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_3 (PROP(requestType, string),
-        PROP(subscribe, boolean), PROP(streamType, string)) REQUIRED_3(requestType, subscribe, streamType)));
-
-    if (!msg.parse(__FUNCTION__,sh))
+    const unsigned int requestParams = FOCUS_PARAM_REQUEST_TYPE | FOCUS_PARAM_SUBSCRIBE | FOCUS_PARAM_STREAM_TYPE;
+    if (!parseFocusRequestMessage(sh, message, STRICT_SCHEMA(PROPS_3 (PROP(requestType, string),
+        PROP(subscribe, boolean), PROP(streamType, string)) REQUIRED_3(requestType, subscribe, streamType)),
+        requestParams, requestParams, __FUNCTION__, params))
        return true;
     std::string sessionInfo = LSMessageGetSessionId(message);
     displayId = getSessionDisplayId(sessionInfo);
 #else
-
-    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_4 (PROP(requestType, string), PROP(displayId, integer),
-                                    PROP(subscribe, boolean), PROP(streamType, string)) REQUIRED_4(requestType, displayId, subscribe, streamType)));
-
-    if (!msg.parse(__FUNCTION__,sh))
+    const unsigned int requestParams = FOCUS_PARAM_REQUEST_TYPE | FOCUS_PARAM_DISPLAY_ID | FOCUS_PARAM_SUBSCRIBE | \
+                                       FOCUS_PARAM_STREAM_TYPE;
+    if (!parseFocusRequestMessage(sh, message, STRICT_SCHEMA(PROPS_4 (PROP(requestType, string), PROP(displayId, integer),
+        PROP(subscribe, boolean), PROP(streamType, string)) REQUIRED_4(requestType, displayId, subscribe, streamType)),
+        requestParams, requestParams, __FUNCTION__, params))
        return true;
-    msg.get("displayId", displayId);
+    displayId = params.displayId;
 #endif
+    bool subscription = params.subscribe;
 
-
-
-    msg.get("requestType", requestName);
-    msg.get("subscribe", subscription);
-    msg.get("streamType", streamType);
-
-    if (!validateDisplayId(displayId))
+    if (!mFocusEngine.validateDisplayId(displayId))
     {
-        reply = STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_DISPLAY_ID, "Invalid displayId");
-        LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_DISPLAY_ID, "Invalid displayId"), eLSReply, false);
         return true;
     }
     const char* appId = LSMessageGetApplicationID(message);
@@ -304,418 +463,360 @@ bool AudioFocusManager::requestFocus(LSHandle *sh, LSMessage *message, void *dat
         appId = LSMessageGetSenderServiceName(message);
         if (appId == NULL)
         {
-            reply = STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "appId received as NULL");
-            LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
+            LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "appId received as NULL"), eLSReply, false);
             return true;
         }
     }
-    const auto& it = mAFRequestPolicyInfo.find(requestName);
-    if (it != mAFRequestPolicyInfo.end())
-        PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "Valid request type received");
+    int requestTypeId = mFocusEngine.getPolicy().getRequestTypeId(params.requestType.data, params.requestType.length);
+    if (requestTypeId != AF_INVALID_REQUEST_TYPE)
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "Valid request type received");
     else
     {
-        reply = STANDARD_JSON_ERROR(AF_ERR_CODE_UNKNOWN_REQUEST, "Invalid Request Type");
-        LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_UNKNOWN_REQUEST, "Invalid Request Type"), eLSReply, false);
         return true;
     }
 
     if (!subscription)
     {
-        reply = STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "Subscription should be true");
-        LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "Subscription should be true"), eLSReply, false);
         return true;
     }
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "requestFocus: displayId: %d requestType: %s appId: %s streamType: %s", \
-        displayId, requestName.c_str(), appId, streamType.c_str());
-    if (checkGrantedAlready(sh, message, appId, displayId, requestName))
-        return true;
-    if (!checkFeasibility(displayId, requestName))
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "requestFocus: displayId: %d requestType: %.*s appId: %s streamType: %.*s", \
+        displayId, (int) params.requestType.length, params.requestType.data, appId, \
+        (int) params.streamType.length, params.streamType.data);
+    AppNotificationList notifications;
+    const char* result = nullptr;
+    uint64_t focusHandle = 0;
+    if (!mFocusEngine.requestFocus(displayId, appId, requestTypeId, params.streamType.str(), notifications, result,
+        focusHandle))
     {
-        sendApplicationResponse(sh, message, "AF_CANNOTBEGRANTED");
+        sendApplicationResponse(sh, message, result, focusHandle);
         return true;
     }
-    sendApplicationResponse(sh, message, "AF_GRANTED");
-    if (LSMessageIsSubscription(message))
-        LSSubscriptionAdd(sh, "AFSubscriptionList", message, NULL);
-    updateDisplayActiveAppList(displayId, appId, requestName, streamType);
-    broadcastStatusToSubscribers(displayId);
+    manageAppSubscription(notifications);
+    sendApplicationResponse(sh, message, result, focusHandle);
+    if (LSMessageIsSubscription(message) && LSSubscriptionAdd(sh, AF_SUBSCRIPTION_LIST, message, NULL))
+        addFocusSubscription(message, std::vector<uint64_t>(1, focusHandle), false);
+    scheduleStatusBroadcast(displayId);
     return true;
 }
+
 /*
 Functionality of this method:
-Validating the display Id by matching it with the display Id
+->This will unsubscribe the app and removes its entry.
+->Sends resume event to the application which is in paused state if there are any such applications.
+->The entry is the one of focusHandle, or else the first one of streamType. Unlike earlier releases, a
+  streamType the application holds no entry of is an error and nothing is released: it used to be
+  ignored and the first entry of the application was released, which could take away an unrelated one.
+  Callers have to send the streamType they requested with, or the focusHandle.
 */
-
-#if defined(WEBOS_SOC_AUTO)
-bool AudioFocusManager::validateDisplayId(int displayId)
+bool AudioFocusManager::releaseFocus(LSHandle *sh, LSMessage *message, void *data)
 {
-    if(displayId == DISPLAY_ID_0 || displayId == DISPLAY_ID_1 || displayId == DISPLAY_ID_2)
+    int displayId = -1;
+    FOCUS_REQUEST_PARAMS_T params;
+#if defined(WEBOS_SOC_AUTO)
+    const unsigned int releaseParams = FOCUS_PARAM_STREAM_TYPE | FOCUS_PARAM_FOCUS_HANDLE;
+    if (!parseFocusRequestMessage(sh, message, STRICT_SCHEMA(PROPS_2(PROP(streamType, string), PROP(focusHandle, integer))),
+        releaseParams, 0, __FUNCTION__, params))
         return true;
-    else
-        return false;
-}
+    std::string sessionInfo = LSMessageGetSessionId(message);
+    displayId = getSessionDisplayId(sessionInfo);
 #else
-bool AudioFocusManager::validateDisplayId(int displayId)
-{
-    if(displayId == DISPLAY_ID_0 || displayId == DISPLAY_ID_1 )
+    const unsigned int releaseParams = FOCUS_PARAM_DISPLAY_ID | FOCUS_PARAM_STREAM_TYPE | FOCUS_PARAM_FOCUS_HANDLE;
+    if (!parseFocusRequestMessage(sh, message, STRICT_SCHEMA(PROPS_3(PROP(displayId, integer), PROP(streamType, string),
+        PROP(focusHandle, integer)) REQUIRED_1(displayId)), releaseParams, FOCUS_PARAM_DISPLAY_ID, __FUNCTION__, params))
         return true;
-    else
-        return false;
-}
+    displayId = params.displayId;
 #endif
-/*
-Functionality of this method:
-->Checks whether the incoming request is duplicate request or not.
-->If it is a duplicate request sends AF_GRANTEDALREADY event to the app.
-*/
-bool AudioFocusManager::checkGrantedAlready(LSHandle *sh, LSMessage *message, std::string applicationId,\
-    const int& displayId, const std::string& requestType)
-{
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkGrantedAlready for appId:%s displayId:%d requestType:%s",\
-        applicationId.c_str(), displayId, requestType.c_str());
-    auto it = mDisplayInfoMap.find(displayId);
-    if (it == mDisplayInfoMap.end())
-    {
-        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"Request from a new display %d", displayId);
-        return false;
-    }
-    DISPLAY_INFO_T& displayInfo = it->second;
-    for (auto itPaused = displayInfo.pausedAppList.begin(); \
-            itPaused != displayInfo.pausedAppList.end(); itPaused++)
+    //The entry is given either by its handle or by its stream
+    if (!(params.presentParams & (FOCUS_PARAM_STREAM_TYPE | FOCUS_PARAM_FOCUS_HANDLE)))
     {
-        if (itPaused->requestType == requestType && \
-                itPaused->appId == applicationId)
-        {
-            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkGrantedAlready: AF_GRANTEDALREADY in paused list:%s", applicationId.c_str());
-            sendApplicationResponse(sh, message, "AF_GRANTEDALREADY");
-            return true;
-        }
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_SCHEMA, "Invalid Schema"), eLSReply, false);
+        return true;
     }
-    for (auto itActive = displayInfo.activeAppList.begin(); \
-            itActive != displayInfo.activeAppList.end(); itActive++)
+    if ((params.presentParams & FOCUS_PARAM_FOCUS_HANDLE) && params.focusHandle == 0)
     {
-        if (itActive->requestType == requestType && \
-                itActive->appId == applicationId)
-        {
-            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkGrantedAlready: AF_GRANTEDALREADY in active list%s", applicationId.c_str());
-            sendApplicationResponse(sh, message, "AF_GRANTEDALREADY");
-            return true;
-        }
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_SCHEMA, "Invalid focusHandle"), eLSReply, false);
+        return true;
     }
-    return false;
-}
 
-/*Functionality of this method:
- * To check if active request types in the requesting display has any request which will not grant the new request type*/
-bool AudioFocusManager::checkFeasibility(const int& displayId, const std::string& newRequestType)
-{
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility for displayId:%d newRequestType:%s",\
-        displayId, newRequestType.c_str());
-    auto itDisplay = mDisplayInfoMap.find(displayId);
-    if (itDisplay == mDisplayInfoMap.end())
+    if (!mFocusEngine.validateDisplayId(displayId))
     {
-        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: New display entry for:%d Request feasible", displayId);
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_DISPLAY_ID, "Invalid displayId"), eLSReply, false);
         return true;
     }
-    DISPLAY_INFO_T& curdisplayInfo = itDisplay->second;
-    //Check feasiblity in activeAppList pair to pair
-    if (checkIncomingPair(newRequestType, curdisplayInfo.activeAppList))
+    const char* appId = LSMessageGetApplicationID(message);
+    if (appId == NULL)
     {
-        for (auto itActive = curdisplayInfo.activeAppList.begin(); itActive != curdisplayInfo.activeAppList.end(); itActive++)
+        appId = LSMessageGetSenderServiceName(message);
+        if (appId == NULL)
         {
-            auto itActiveRequestPolicy = mAFRequestPolicyInfo.find(itActive->requestType);
-            if (itActiveRequestPolicy != mAFRequestPolicyInfo.end())
-            {
-                REQUEST_TYPE_POLICY_INFO_T& activeRequestPolicy = itActiveRequestPolicy->second;
-                std::string policyAction = getFocusPolicyType(newRequestType, activeRequestPolicy.incomingRequestInfo);
-                if ("pause" == policyAction)
-                {
-                    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: send AF_PAUSE to %s", \
-                        itActive->appId.c_str());
-                    manageAppSubscription(itActive->appId, "AF_PAUSE", 's');
-                    curdisplayInfo.pausedAppList.push_back(*itActive);
-                    curdisplayInfo.activeAppList.erase(itActive--);
-                }
-                else if("lost" == policyAction)
-                {
-                    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: send AF_LOST to %s", \
-                        itActive->appId.c_str());
-                    manageAppSubscription(itActive->appId, "AF_LOST", 'n');
-                    curdisplayInfo.activeAppList.erase(itActive--);
-                }
-                else
-                    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: App can mix and play %s", \
-                        itActive->appId.c_str());
-            }
-            else
-                PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "checkFeasibility requestType:%s not found in mAFRequestPolicyInfo", itActive->requestType.c_str());
+            LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "Internal error"), eLSReply, false);
+            return true;
         }
     }
-    else
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"releaseFocus: displayId: %d appId: %s streamType: %.*s", displayId, appId, \
+        (int) params.streamType.length, params.streamType.data);
+    const DisplayFocusState& displayInfo = mFocusEngine.getDisplay(displayId);
+    if (!(displayInfo.getActiveRequestTypeMask() | displayInfo.getPausedRequestTypeMask()))
     {
-        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: newRequestType cannot be granted");
-        return false;
+        PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT,"releaseFocus: no requests in display %d", displayId);
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "No active requests found for the application"), eLSReply, false);
+        return true;
     }
-    //Check feasiblity in pausedAppList pair to pair
-    //Not checking for incoming list availability for incoming request type
-    for (auto itPaused = curdisplayInfo.pausedAppList.begin(); itPaused != curdisplayInfo.pausedAppList.end(); itPaused++)
+    AppNotificationList notifications;
+    std::string streamType = params.streamType.str();
+    bool hasStreamType = (params.presentParams & FOCUS_PARAM_STREAM_TYPE);
+    if (mFocusEngine.releaseFocus(displayId, appId, hasStreamType ? &streamType : nullptr, params.focusHandle,
+        notifications))
     {
-        auto itPausedRequestPolicy = mAFRequestPolicyInfo.find(itPaused->requestType);
-        if (itPausedRequestPolicy != mAFRequestPolicyInfo.end())
-        {
-            REQUEST_TYPE_POLICY_INFO_T& pausedRequestPolicy = itPausedRequestPolicy->second;
-            std::string policyAction = getFocusPolicyType(newRequestType, pausedRequestPolicy.incomingRequestInfo);
-            if ("lost" == policyAction)
-            {
-                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: send AF_PAUSE to %s", \
-                    itPaused->appId.c_str());
-                manageAppSubscription(itPaused->appId, "AF_LOST", 's');
-                curdisplayInfo.pausedAppList.erase(itPaused--);
-            }
-            else
-                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: App can mix and play or already paused%s", \
-                    itPaused->appId.c_str());
-        }
-        else
-            PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "checkFeasibility requestType:%s not found in mAFRequestPolicyInfo", itPaused->requestType.c_str());
+        manageAppSubscription(notifications);
+        scheduleStatusBroadcast(displayId);
+        sendApplicationResponse(sh, message, "AF_SUCCESSFULLY_RELEASED");
+        return true;
     }
+
+    PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "releaseFocus: appId: %s, streamType: %.*s is not found in display: %d" , \
+        appId, (int) params.streamType.length, params.streamType.data, displayId);
+    LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "Application not registered"), eLSReply, false);
     return true;
 }
 
-bool AudioFocusManager::checkIncomingPair(const std::string& newRequestType, const std::list<APP_INFO_T>& appList)
+//Application id of the sender of message, nullptr if there is none
+static const char* getRequesterAppId(LSMessage *message)
 {
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkIncomingPair: newRequestType:%s", newRequestType.c_str());
-    bool isPairFound = false;
-    for (auto itActive = appList.begin(); itActive != appList.end(); itActive++)
-    {
-        auto itActiveRequestPolicy = mAFRequestPolicyInfo.find(itActive->requestType);
-        if (itActiveRequestPolicy != mAFRequestPolicyInfo.end())
-        {
-            REQUEST_TYPE_POLICY_INFO_T& activeRequestPolicy = itActiveRequestPolicy->second;
-            if (activeRequestPolicy.incomingRequestInfo.isArray())
-            {
-                for (const pbnjson::JValue& elements : activeRequestPolicy.incomingRequestInfo.items())
-                {
-                    if (elements.hasKey(newRequestType))
-                    {
-                        isPairFound = true;
-                        break;
-                    }
-                }
-            }
-            else
-                PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT,"checkIncomingPair incomingRequestInfo not an array");
-        }
-        else
-            PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT,"checkIncomingPair requestType not found:%s", itActive->requestType.c_str());
-        if (isPairFound)
-            isPairFound = false;
-        else
-            return false;
-    }
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkIncomingPair found in the active list");
-    return true;
+    const char* appId = LSMessageGetApplicationID(message);
+    if (appId == NULL)
+        appId = LSMessageGetSenderServiceName(message);
+    return appId;
 }
 
-std::string AudioFocusManager::getFocusPolicyType(const std::string& newRequestType, const pbnjson::JValue& incomingRequestInfo)
+//Items released by focusHandle only have no name to echo, the handle is echoed instead
+static void appendBatchItemResult(std::string& reply, const char* name, const std::string& value, const char* result,
+    const char* errorText, int errorCode, uint64_t focusHandle)
 {
-    pbnjson::JValue requestInfo = incomingRequestInfo;
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"getFocusPolicyType: newRequestType:%s incomingRequestInfo:%s", \
-        newRequestType.c_str(), requestInfo.stringify().c_str());
-    std::string focusType;
-    if (incomingRequestInfo.isArray())
+    reply += '{';
+    if (name)
     {
-        for (const pbnjson::JValue& elements : incomingRequestInfo.items())
-        {
-            if (elements.hasKey(newRequestType))
-            {
-                if (elements[newRequestType].asString(focusType) == CONV_OK)
-                    return focusType;
-                else
-                    PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT,"getFocusPolicyType: focusType could not be extracted");
-            }
-        }
+        reply += '"';
+        reply += name;
+        reply += "\":";
+        appendJsonString(reply, value);
+        reply += ',';
+    }
+    if (errorText)
+    {
+        reply += "\"returnValue\":false,\"errorCode\":";
+        reply += std::to_string(errorCode);
+        reply += ",\"errorText\":";
+        appendJsonString(reply, errorText, strlen(errorText));
     }
     else
-        PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT,"getFocusPolicyType: incomingRequestInfo is not an array");
-    return focusType;
-}
-
-/*Functionality of this methos:
- * -> Update the display active app list if display already present
- *  ->Create new display Info and update active app list
- */
-void AudioFocusManager::updateDisplayActiveAppList(const int& displayId, const std::string& appId, const std::string& requestType, const std::string& streamType)
-{
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"updateDisplayActiveAppList: displayId: %d", displayId);
-    APP_INFO_T newAppInfo;
-    newAppInfo.appId = appId;
-    newAppInfo.requestType = requestType;
-    newAppInfo.streamType = streamType;
-    auto itDisplay = mDisplayInfoMap.find(displayId);
-    if (itDisplay == mDisplayInfoMap.end())
-    {
-        DISPLAY_INFO_T newdisplayInfo;
-        newdisplayInfo.activeAppList.push_back(newAppInfo);
-        mDisplayInfoMap[displayId] = newdisplayInfo;
-        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"updateDisplayActiveAppList: new display details added. Display: %d", \
-            displayId);
-        return;
+    {
+        reply += "\"returnValue\":true,\"result\":";
+        appendJsonString(reply, result, strlen(result));
     }
-    DISPLAY_INFO_T& displayInfo = itDisplay->second;
-    displayInfo.activeAppList.push_back(newAppInfo);
+    if (focusHandle)
+    {
+        reply += ",\"focusHandle\":";
+        reply += std::to_string(focusHandle);
+    }
+    reply += '}';
 }
 
 /*
-Functionality of this method:
-->This will unsubscribe the app and removes its entry.
-->Sends resume event to the application which is in paused state if there are any such applications.
-*/
-bool AudioFocusManager::releaseFocus(LSHandle *sh, LSMessage *message, void *data)
+ * Functionality of this method:
+ * ->Applies several focus requests of one application in a single call, in the given order.
+ *   Each request sees the state left by the previous ones, nothing else runs in between.
+ * ->The notifications of all the requests are sent together, followed by a single status broadcast.
+ * ->The reply has one result per request. A request granted here but paused or lost because of a
+ *   later one of the same batch reports AF_PAUSE or AF_LOST.
+ */
+bool AudioFocusManager::requestFocusBatch(LSHandle *sh, LSMessage *message, void *data)
 {
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"requestFocusBatch");
     int displayId = -1;
-    std::string reply;
-    std::string streamType;
+    bool subscription = false;
 #if defined(WEBOS_SOC_AUTO)
-    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_1(PROP(streamType, string)) REQUIRED_1(streamType)));
+    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_2(PROP(subscribe, boolean),
+        PROP_ARRAY(requests, STRICT_SCHEMA(PROPS_2(PROP(requestType, string), PROP(streamType, string))
+        REQUIRED_2(requestType, streamType)))) REQUIRED_2(subscribe, requests)));
     if (!msg.parse(__FUNCTION__, sh))
         return true;
     std::string sessionInfo = LSMessageGetSessionId(message);
     displayId = getSessionDisplayId(sessionInfo);
 #else
-    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_2(PROP(displayId, integer), PROP(streamType, string)) REQUIRED_2(displayId, streamType)));
+    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_3(PROP(displayId, integer), PROP(subscribe, boolean),
+        PROP_ARRAY(requests, STRICT_SCHEMA(PROPS_2(PROP(requestType, string), PROP(streamType, string))
+        REQUIRED_2(requestType, streamType)))) REQUIRED_3(displayId, subscribe, requests)));
     if (!msg.parse(__FUNCTION__, sh))
         return true;
     msg.get("displayId", displayId);
 #endif
+    msg.get("subscribe", subscription);
 
-    msg.get("streamType", streamType);
-
-    if (!validateDisplayId(displayId))
+    if (!mFocusEngine.validateDisplayId(displayId))
     {
-        reply = STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_DISPLAY_ID, "Invalid displayId");
-        LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_DISPLAY_ID, "Invalid displayId"), eLSReply, false);
         return true;
     }
-    const char* appId = LSMessageGetApplicationID(message);
+    const char* appId = getRequesterAppId(message);
     if (appId == NULL)
     {
-        appId = LSMessageGetSenderServiceName(message);
-        if (appId == NULL)
-        {
-            reply = STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "Internal error");
-            LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
-            return true;
-        }
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "appId received as NULL"), eLSReply, false);
+        return true;
     }
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"releaseFocus: displayId: %d appId: %s streamType: %s", displayId, appId, streamType.c_str());
-    auto itDisplay = mDisplayInfoMap.find(displayId);
-    if (itDisplay == mDisplayInfoMap.end())
+    if (!subscription)
     {
-        PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT,"releaseFocus: display ID cannot be find");
-        reply = STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "No active requests found for the application");
-        LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "Subscription should be true"), eLSReply, false);
         return true;
     }
-    DISPLAY_INFO_T& curdisplayInfo = itDisplay->second;
-    for (auto itPaused = curdisplayInfo.pausedAppList.begin(); itPaused != curdisplayInfo.pausedAppList.end(); itPaused++)
+    pbnjson::JValue requests = msg.get()["requests"];
+    ssize_t requestCount = requests.arraySize();
+    if (requestCount <= 0 || requestCount > AF_MAX_BATCH_SIZE)
     {
-        if (itPaused->appId == appId)
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_SCHEMA, "Invalid number of requests"), eLSReply, false);
+        return true;
+    }
+
+    std::vector<BATCH_ITEM_RESULT_T> results(requestCount);
+    AppNotificationList notifications;
+    std::vector<uint64_t> grantedFocusHandles;
+    for (ssize_t index = 0; index < requestCount; index++)
+    {
+        BATCH_ITEM_RESULT_T& item = results[index];
+        std::string streamType;
+        requests[index]["requestType"].asString(item.name);
+        requests[index]["streamType"].asString(streamType);
+        item.requestTypeId = mFocusEngine.getPolicy().getRequestTypeId(item.name);
+        if (item.requestTypeId == AF_INVALID_REQUEST_TYPE)
         {
-            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "releaseFocus: Removing appId: %s Request type: %s", \
-                appId, itPaused->requestType.c_str());
-            manageAppSubscription(appId, "AF_RELEASED", 'r');
-            curdisplayInfo.pausedAppList.erase(itPaused--);
-            broadcastStatusToSubscribers(displayId);
-            sendApplicationResponse(sh, message, "AF_SUCCESSFULLY_RELEASED");
-            return true;
+            item.errorText = "Invalid Request Type";
+            item.errorCode = AF_ERR_CODE_UNKNOWN_REQUEST;
+            continue;
         }
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "requestFocusBatch: displayId: %d requestType: %s appId: %s streamType: %s", \
+            displayId, item.name.c_str(), appId, streamType.c_str());
+        item.granted = mFocusEngine.requestFocus(displayId, appId, item.requestTypeId, streamType, notifications,
+            item.result, item.focusHandle);
+        if (item.granted)
+            grantedFocusHandles.push_back(item.focusHandle);
     }
+    bool anyGranted = !grantedFocusHandles.empty();
 
-    for (auto itActive = curdisplayInfo.activeAppList.begin(); itActive != curdisplayInfo.activeAppList.end(); itActive++)
+    std::string reply = "{\"returnValue\":true,\"subscribed\":true,\"results\":[";
+    std::vector<uint64_t> focusHandles;
+    for (auto& item : results)
     {
-        if (itActive->appId == appId)
+        const APP_INFO_T* appInfo = item.granted ? mFocusEngine.getFocusEntry(item.focusHandle) : nullptr;
+        if (item.granted && !appInfo)
         {
-            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"releaseFocus: Removing appId: %s Request type: %s", \
-                appId, itActive->requestType.c_str());
-            manageAppSubscription(appId, "AF_RELEASED", 'r');
-            std::string requestType = itActive->requestType;
-            curdisplayInfo.activeAppList.erase(itActive--);
-            pausedAppToActive(curdisplayInfo, requestType);
-            broadcastStatusToSubscribers(displayId);
-            sendApplicationResponse(sh, message, "AF_SUCCESSFULLY_RELEASED");
-            return true;
+            item.result = "AF_LOST";
+            item.focusHandle = 0;
         }
+        else if (item.granted && appInfo->isPaused)
+            item.result = "AF_PAUSE";
+        if (item.granted && item.focusHandle)
+            focusHandles.push_back(item.focusHandle);
+        if (&item != &results.front())
+            reply += ',';
+        appendBatchItemResult(reply, "requestType", item.name, item.result, item.errorText, item.errorCode,
+            item.focusHandle);
     }
+    reply += "]}";
 
-    PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "releaseFocus: appId: %s, streamType: %s is not found in display: %d" , \
-        appId, streamType.c_str(), displayId);
-    reply = STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "Application not registered");
+    //The reply already tells how the entries of this batch ended up, their own events are not sent
+    notifications.erase(std::remove_if(notifications.begin(), notifications.end(),
+        [&grantedFocusHandles](const APP_NOTIFICATION_T& notification) {
+            return std::find(grantedFocusHandles.begin(), grantedFocusHandles.end(), notification.focusHandle) != \
+                grantedFocusHandles.end();
+        }), notifications.end());
+    manageAppSubscription(notifications);
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"requestFocusBatch: %s", reply.c_str());
     LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
+    if (anyGranted)
+    {
+        //Entries all lost within the batch leave nothing to subscribe for
+        if (!focusHandles.empty() && LSMessageIsSubscription(message) && \
+            LSSubscriptionAdd(sh, AF_SUBSCRIPTION_LIST, message, NULL))
+            addFocusSubscription(message, focusHandles, true);
+        scheduleStatusBroadcast(displayId);
+    }
     return true;
 }
 
-bool AudioFocusManager::pausedAppToActive(DISPLAY_INFO_T& displayInfo, const std::string& removedRequest)
+/*
+ * Functionality of this method:
+ * ->Releases several entries of one application in a single call, with one result per entry.
+ * ->As for releaseFocus, each item gives the entry by its focusHandle or by its streamType.
+ */
+bool AudioFocusManager::releaseFocusBatch(LSHandle *sh, LSMessage *message, void *data)
 {
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "pausedAppToActive for removedRequest:%s", removedRequest.c_str());
-    if (displayInfo.pausedAppList.size() == 1 && displayInfo.activeAppList.empty())
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"releaseFocusBatch");
+    int displayId = -1;
+#if defined(WEBOS_SOC_AUTO)
+    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_1(PROP_ARRAY(releases,
+        STRICT_SCHEMA(PROPS_2(PROP(streamType, string), PROP(focusHandle, integer))))) REQUIRED_1(releases)));
+    if (!msg.parse(__FUNCTION__, sh))
+        return true;
+    std::string sessionInfo = LSMessageGetSessionId(message);
+    displayId = getSessionDisplayId(sessionInfo);
+#else
+    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_2(PROP(displayId, integer), PROP_ARRAY(releases,
+        STRICT_SCHEMA(PROPS_2(PROP(streamType, string), PROP(focusHandle, integer))))) REQUIRED_2(displayId, releases)));
+    if (!msg.parse(__FUNCTION__, sh))
+        return true;
+    msg.get("displayId", displayId);
+#endif
+
+    if (!mFocusEngine.validateDisplayId(displayId))
     {
-        auto& itPaused = displayInfo.pausedAppList.back();
-        displayInfo.activeAppList.push_back(itPaused);
-        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "pausedAppToActive: send AF_GRANETD to %s", itPaused.appId.c_str());
-        manageAppSubscription(itPaused.appId, "AF_GRANTED", 's');
-        displayInfo.pausedAppList.pop_back();
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_DISPLAY_ID, "Invalid displayId"), eLSReply, false);
+        return true;
     }
-    else
+    const char* appId = getRequesterAppId(message);
+    if (appId == NULL)
     {
-        for (auto itPaused = displayInfo.pausedAppList.begin(); itPaused != displayInfo.pausedAppList.end(); itPaused++)
-        {
-            auto itPausedRequestPolicy = mAFRequestPolicyInfo.find(itPaused->requestType);
-            if (itPausedRequestPolicy != mAFRequestPolicyInfo.end())
-            {
-                REQUEST_TYPE_POLICY_INFO_T& pausedRequestPolicy = itPausedRequestPolicy->second;
-                std::string policyAction = getFocusPolicyType(removedRequest, pausedRequestPolicy.incomingRequestInfo);
-                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"pausedAppToActive policyAction:%s", policyAction.c_str());
-                if ("pause" == policyAction && isIncomingPairRequestTypeActive(itPaused->requestType, displayInfo))
-                {
-                    displayInfo.activeAppList.push_back(*itPaused);
-                    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "pausedAppToActive: send AF_GRANETD to %s", itPaused->appId.c_str());
-                    manageAppSubscription(itPaused->appId, "AF_GRANTED", 's');
-                    itPaused = displayInfo.pausedAppList.erase(itPaused);
-                    --itPaused;
-                }
-                else
-                    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"pausedAppToActive incomingPairRequestType is not active");
-            }
-            else
-                PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT,"pausedAppToActive requestType not found:%s", itPaused->requestType.c_str());
-        }
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INTERNAL, "Internal error"), eLSReply, false);
+        return true;
+    }
+    pbnjson::JValue releases = msg.get()["releases"];
+    ssize_t releaseCount = releases.arraySize();
+    if (releaseCount <= 0 || releaseCount > AF_MAX_BATCH_SIZE)
+    {
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_SCHEMA, "Invalid number of releases"), eLSReply, false);
+        return true;
     }
-    return true;
-}
 
-//Check if any other active app incoming request list does not have pause for already paused app, do not resume in that case
-bool AudioFocusManager::isIncomingPairRequestTypeActive(const std::string& requestType, const DISPLAY_INFO_T& displayInfo)
-{
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "isIncomingPairRequestTypeActive for requestType:%s", requestType.c_str());
-    for (auto itActive = displayInfo.activeAppList.begin(); itActive != displayInfo.activeAppList.end(); itActive++)
+    AppNotificationList notifications;
+    bool anyReleased = false;
+    std::string reply = "{\"returnValue\":true,\"results\":[";
+    for (ssize_t index = 0; index < releaseCount; index++)
     {
-        auto itPausedRequestPolicy = mAFRequestPolicyInfo.find(requestType);
-        if (itPausedRequestPolicy != mAFRequestPolicyInfo.end())
-        {
-            REQUEST_TYPE_POLICY_INFO_T& pausedRequestPolicy = itPausedRequestPolicy->second;
-            if (pausedRequestPolicy.incomingRequestInfo.isArray())
-            {
-                std::string policyAction = getFocusPolicyType(itActive->requestType, pausedRequestPolicy.incomingRequestInfo);
-                if (("pause" == policyAction) || policyAction.empty() || ("lost" == policyAction))
-                    return false;
-            }
-            else
-                PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT,"isIncomingPairRequestTypeActive incomingRequestInfo not an array");
-        }
-        else
-            PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT,"isIncomingPairRequestTypeActive requestType not found:%s", itActive->requestType.c_str());
+        std::string streamType;
+        int64_t focusHandle = 0;
+        bool hasStreamType = (releases[index]["streamType"].asString(streamType) == CONV_OK);
+        bool hasFocusHandle = (releases[index]["focusHandle"].asNumber(focusHandle) == CONV_OK);
+        //A non positive handle names no entry, the item fails rather than falling back to its streamType
+        bool validItem = hasFocusHandle ? (focusHandle > 0) : hasStreamType;
+        bool released = validItem && mFocusEngine.releaseFocus(displayId, appId,
+            hasStreamType ? &streamType : nullptr, (focusHandle > 0) ? focusHandle : 0, notifications);
+        if (!released)
+            PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "releaseFocusBatch: appId: %s, streamType: %s is not found in display: %d", \
+                appId, streamType.c_str(), displayId);
+        if (index)
+            reply += ',';
+        appendBatchItemResult(reply, hasStreamType ? "streamType" : nullptr, streamType, "AF_SUCCESSFULLY_RELEASED", \
+            released ? nullptr : "Application not registered", AF_ERR_CODE_INTERNAL, (focusHandle > 0) ? focusHandle : 0);
+        anyReleased = anyReleased || released;
     }
+    reply += "]}";
+
+    manageAppSubscription(notifications);
+    if (anyReleased)
+        scheduleStatusBroadcast(displayId);
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"releaseFocusBatch: %s", reply.c_str());
+    LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
     return true;
 }
 
@@ -727,50 +828,101 @@ bool AudioFocusManager::getStatus(LSHandle *sh, LSMessage *message, void *data)
 {
     PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"getStatus");
     CLSError lserror;
-    pbnjson::JValue jsonObject = pbnjson::JObject();
     std::string reply;
-    bool subscription;
+    bool subscribed = false;
+    bool delta = false;
+    bool allDisplays = false;
+    int64_t version = -1;
     int displayId = -1;
     std::string streamType;
 #if defined(WEBOS_SOC_AUTO)
-    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_1(PROP(subscribe, boolean))));
+    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_4(PROP(subscribe, boolean), PROP(delta, boolean),
+        PROP(version, integer), PROP(allDisplays, boolean))));
 
     if (!msg.parse(__FUNCTION__, sh))
         return true;
-    std::string sessionInfo = LSMessageGetSessionId(message);
-    displayId = getSessionDisplayId(sessionInfo);
+    msg.get("allDisplays", allDisplays);
+    if (!allDisplays)
+    {
+        std::string sessionInfo = LSMessageGetSessionId(message);
+        displayId = getSessionDisplayId(sessionInfo);
+    }
 #else
-    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_2(PROP(subscribe, boolean), PROP(displayId, integer))
-        REQUIRED_1(displayId)));
+    LSMessageJsonParser msg(message, STRICT_SCHEMA(PROPS_5(PROP(subscribe, boolean), PROP(displayId, integer),
+        PROP(delta, boolean), PROP(version, integer), PROP(allDisplays, boolean))));
     if (!msg.parse(__FUNCTION__, sh))
         return true;
-    msg.get("displayId", displayId);
+    msg.get("allDisplays", allDisplays);
+    //displayId is only optional for allDisplays, which the schema cannot express
+    if (!allDisplays && !msg.get("displayId", displayId))
+    {
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_SCHEMA, "Invalid Schema"), eLSReply, false);
+        return true;
+    }
 
 #endif
 
-    if (!validateDisplayId(displayId))
+    msg.get("version", version);
+    if (allDisplays)
+    {
+        if (LSMessageIsSubscription (message))
+        {
+            subscribed = true;
+            if (!LSSubscriptionAdd(sh, AF_GET_STATUS_ALL_DISPLAYS_KEY, message, &lserror))
+            {
+                lserror.Print(__FUNCTION__,__LINE__);
+            }
+        }
+        reply = getAllDisplaysStatusReply(subscribed, version);
+        if (!LSMessageReply(sh, message, reply.c_str(), &lserror))
+        {
+            PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT,"getStatus: LSMessageReply Failed");
+            return false;
+        }
+        return true;
+    }
+    if (!mFocusEngine.validateDisplayId(displayId))
     {
-        reply = STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_DISPLAY_ID, "Invalid displayId");
-        LSMessageResponse(sh, message, reply.c_str(), eLSReply, false);
+        LSMessageResponse(sh, message, STANDARD_JSON_ERROR(AF_ERR_CODE_INVALID_DISPLAY_ID, "Invalid displayId"), eLSReply, false);
         return true;
     }
-    msg.get("subscribe",subscription);
-    if (LSMessageIsSubscription (message))
+    msg.get("delta", delta);
+    if (delta && LSMessageIsSubscription (message))
     {
-        jsonObject.put("subscribed", true);
-        if (!LSSubscriptionProcess(sh, message, &subscription, &lserror))
+        //The snapshot has to match the state the next delta is computed from.
+        //Without delta subscribers no snapshot was taken since the last changes, it is taken here.
+        DisplayFocusState& displayInfo = mFocusEngine.getDisplay(displayId);
+        if (!displayInfo.isStatusSnapshotCurrent())
+        {
+            if (hasStatusSubscribers(getStatusSubscriptionKey(displayId, true)))
+                flushStatusBroadcasts();
+            else
+                displayInfo.takeStatusSnapshot();
+        }
+        if (!LSSubscriptionAdd(sh, getStatusSubscriptionKey(displayId, true).c_str(), message, &lserror))
         {
             lserror.Print(__FUNCTION__,__LINE__);
         }
+        reply = getStatusDeltaSnapshotReply(displayId, displayInfo);
+        if (!LSMessageReply(sh, message, reply.c_str(), &lserror))
+        {
+            PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT,"getStatus: LSMessageReply Failed");
+            return false;
+        }
+        return true;
     }
-    else
+    if (LSMessageIsSubscription (message))
     {
-        jsonObject.put("subscribed", false);
+        subscribed = true;
+        //Subscribers only get the updates of the display they asked for
+        if (!LSSubscriptionAdd(sh, getStatusSubscriptionKey(displayId).c_str(), message, &lserror))
+        {
+            lserror.Print(__FUNCTION__,__LINE__);
+        }
     }
-    jsonObject.put("returnValue", true);
-    jsonObject.put("audioFocusStatus", getStatusPayload(displayId));
+    reply = getStatusReply(displayId, subscribed, version);
 
-    if(!LSMessageReply(sh, message, jsonObject.stringify().c_str(), &lserror))
+    if(!LSMessageReply(sh, message, reply.c_str(), &lserror))
     {
         PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT,"sendSignal:LSMessageReply Failed");
         return false;
@@ -779,160 +931,462 @@ bool AudioFocusManager::getStatus(LSHandle *sh, LSMessage *message, void *data)
     return true;
 }
 
-/*Functionality of this method
- * TO get the JSON payload for getStatus response in string format
+/*
+ * Functionality of this method:
+ * ->Returns the serialized status of displayId, in the same layout as before:
+ *   [{"displayId":..,"pausedRequests":[..],"activeRequests":[..]}]
+ * ->The string is kept by the display and only rebuilt after its lists changed,
+ *   so repeated getStatus calls and broadcasts reuse it.
  */
-pbnjson::JValue AudioFocusManager::getStatusPayload(const int& displayId)
+const std::string& AudioFocusManager::getStatusPayloadString(const int& displayId)
+{
+    DisplayFocusState& displayInfo = mFocusEngine.getDisplay(displayId);
+    const std::string* cachedStatus = displayInfo.getCachedStatus();
+    if (cachedStatus)
+        return *cachedStatus;
+    std::string status;
+    appendStatusPayload(status, displayId, displayInfo);
+    PM_LOG_DEBUG("getStatusPayloadString: displayId: %d generation: %llu", displayId, \
+        (unsigned long long) displayInfo.getGeneration());
+    return displayInfo.setCachedStatus(std::move(status));
+}
+
+//Written straight from the focus state, the buffer is grown once up front
+void AudioFocusManager::appendStatusPayload(std::string& out, const int& displayId, const DisplayFocusState& displayInfo)
+{
+    //Fixed part of every app entry: {"appId":"","requestType":"","streamType":""},
+    const size_t appEntrySize = 48;
+    const SymbolTable& symbolTable = mFocusEngine.getSymbolTable();
+    const FocusPolicy& focusPolicy = mFocusEngine.getPolicy();
+    size_t size = 64;
+    for (const auto& appInfo : displayInfo.getActiveAppList())
+        size += appEntrySize + symbolTable.getName(appInfo.appId).length() + \
+            focusPolicy.getRequestTypeName(appInfo.requestTypeId).length() + \
+            symbolTable.getName(appInfo.streamType).length();
+    for (const auto& appInfo : displayInfo.getPausedAppList())
+        size += appEntrySize + symbolTable.getName(appInfo.appId).length() + \
+            focusPolicy.getRequestTypeName(appInfo.requestTypeId).length() + \
+            symbolTable.getName(appInfo.streamType).length();
+    out.reserve(out.length() + size);
+
+    out += "[{\"displayId\":";
+    out += std::to_string(displayId);
+    out += ",\"pausedRequests\":[";
+    appendAppInfoArray(out, displayInfo.getPausedAppList());
+    out += "],\"activeRequests\":[";
+    appendAppInfoArray(out, displayInfo.getActiveAppList());
+    out += "]}]";
+}
+
+void AudioFocusManager::appendAppInfoArray(std::string& out, const AppInfoList& appList, bool withEntryId)
 {
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"getStatusPayload");
+    bool first = true;
+    for (const auto& appInfo : appList)
+    {
+        if (!first)
+            out += ',';
+        appendAppInfo(out, appInfo, withEntryId);
+        first = false;
+    }
+}
 
-    pbnjson::JValue audioFocusStatus = pbnjson::JObject();
-    pbnjson::JValue curDisplay = pbnjson::JObject();
-    pbnjson::JArray displaysList = pbnjson::JArray();
-    pbnjson::JArray activeAppArray = pbnjson::JArray();
-    pbnjson::JArray pausedAppArray = pbnjson::JArray();
-    for (auto displayInfomap : mDisplayInfoMap)
+void AudioFocusManager::appendAppInfo(std::string& out, const APP_INFO_T& appInfo, bool withEntryId)
+{
+    if (withEntryId)
     {
-        if (displayId == displayInfomap.first)
-        {
-            DISPLAY_INFO_T& displayInfo = displayInfomap.second;
-            for (auto &activeAppInfo : displayInfo.activeAppList)
-            {
-                pbnjson::JValue activeApp = pbnjson::JObject();
-                activeApp.put("appId", activeAppInfo.appId);
-                activeApp.put("requestType", activeAppInfo.requestType);
-                activeApp.put("streamType", activeAppInfo.streamType);
-                activeAppArray.append(activeApp);
-            }
-            for (auto &pausedAppInfo : displayInfo.pausedAppList)
-            {
-                pbnjson::JValue pausedApp = pbnjson::JObject();
-                pausedApp.put("appId", pausedAppInfo.appId);
-                pausedApp.put("requestType", pausedAppInfo.requestType);
-                pausedApp.put("streamType", pausedAppInfo.streamType);
-                pausedAppArray.append(pausedApp);
-            }
-        }
+        out += "{\"entryId\":";
+        out += std::to_string(appInfo.entryId);
+        out += ",\"appId\":";
     }
-    curDisplay.put("displayId", displayId);
-    curDisplay.put("pausedRequests", pausedAppArray);
-    curDisplay.put("activeRequests",activeAppArray);
-    displaysList.append(curDisplay);
+    else
+        out += "{\"appId\":";
+    const SymbolTable& symbolTable = mFocusEngine.getSymbolTable();
+    appendJsonString(out, symbolTable.getName(appInfo.appId));
+    out += ",\"requestType\":";
+    appendJsonString(out, mFocusEngine.getPolicy().getRequestTypeName(appInfo.requestTypeId));
+    out += ",\"streamType\":";
+    appendJsonString(out, symbolTable.getName(appInfo.streamType));
+    out += '}';
+}
+
+//getStatus subscriptions are kept per display, under "/getStatus/<displayId>" and "/getStatus/<displayId>/delta"
+std::string AudioFocusManager::getStatusSubscriptionKey(int displayId, bool delta)
+{
+    std::string key = AF_API_GET_STATUS "/" + std::to_string(displayId);
+    if (delta)
+        key += "/delta";
+    return key;
+}
 
-    return displaysList;
+/*
+ * Functionality of this method:
+ * ->Complete getStatus reply, as sent to the caller and to the subscribers.
+ * ->version is the generation of the display, it increases with every change of its status.
+ *   A caller passing the version it already has gets a notModified reply without the status.
+ *   A version of another run of the service has another epoch and never matches.
+ */
+std::string AudioFocusManager::getStatusReply(const int& displayId, bool subscribed, int64_t knownVersion)
+{
+    static const char subscribedPrefix[] = "{\"returnValue\":true,\"subscribed\":true,\"version\":";
+    static const char unsubscribedPrefix[] = "{\"returnValue\":true,\"subscribed\":false,\"version\":";
+    const DisplayFocusState& displayInfo = mFocusEngine.getDisplay(displayId);
+    uint64_t version = makeStatusVersion(displayInfo.getGeneration());
+    std::string reply = subscribed ? subscribedPrefix : unsubscribedPrefix;
+    if (knownVersion >= 0 && (uint64_t) knownVersion == version)
+    {
+        reply += std::to_string(version);
+        reply += ",\"notModified\":true}";
+        return reply;
+    }
+    const std::string& status = getStatusPayloadString(displayId);
+    reply.reserve(sizeof(unsubscribedPrefix) + 48 + status.length());
+    reply += std::to_string(version);
+    reply += ",\"audioFocusStatus\":";
+    reply += status;
+    reply += '}';
+    return reply;
+}
+
+//Epoch of this run above the generation, a generation wrapping past 32 bits only matters to a client that
+//kept a version over four billion changes
+uint64_t AudioFocusManager::makeStatusVersion(uint64_t generation) const
+{
+    return (mStatusVersionEpoch << AF_STATUS_VERSION_GENERATION_BITS) | \
+        (generation & ((1ull << AF_STATUS_VERSION_GENERATION_BITS) - 1));
 }
 
 /*
  * Functionality of this method:
- * Notigy /getStatus subscribers on the current AudioFocusManager status
+ * ->getStatus reply with the status of every display, all taken from the same state.
+ * ->The version is the generation last given to any display, so it changes with every change
+ *   of any of them.
  */
+std::string AudioFocusManager::getAllDisplaysStatusReply(bool subscribed, int64_t knownVersion)
+{
+    uint64_t version = makeStatusVersion(DisplayFocusState::getLastGeneration());
+    std::string reply = subscribed ? "{\"returnValue\":true,\"subscribed\":true,\"allDisplays\":true,\"version\":" :
+                                     "{\"returnValue\":true,\"subscribed\":false,\"allDisplays\":true,\"version\":";
+    reply += std::to_string(version);
+    if (knownVersion >= 0 && (uint64_t) knownVersion == version)
+    {
+        reply += ",\"notModified\":true}";
+        return reply;
+    }
+    size_t size = reply.length() + 32;
+    for (int displayId = DISPLAY_ID_0; mFocusEngine.validateDisplayId(displayId); displayId++)
+        size += getStatusPayloadString(displayId).length();
+    reply.reserve(size);
+    reply += ",\"audioFocusStatus\":[";
+    for (int displayId = DISPLAY_ID_0; mFocusEngine.validateDisplayId(displayId); displayId++)
+    {
+        //Every display status is a one element array, only its element is taken
+        const std::string& status = getStatusPayloadString(displayId);
+        if (displayId != DISPLAY_ID_0)
+            reply += ',';
+        reply.append(status, 1, status.length() - 2);
+    }
+    reply += "]}";
+    return reply;
+}
+
+/*
+ * Functionality of this method:
+ * ->First reply of a delta subscription: the full status of the display as of the last
+ *   broadcast, with the entryId of every entry and the sequence the following deltas build on.
+ */
+std::string AudioFocusManager::getStatusDeltaSnapshotReply(const int& displayId, const DisplayFocusState& displayInfo)
+{
+    std::string reply = "{\"returnValue\":true,\"subscribed\":true,\"delta\":true,\"sequence\":";
+    reply += std::to_string(displayInfo.getStatusSequence());
+    reply += ",\"audioFocusStatus\":[{\"displayId\":";
+    reply += std::to_string(displayId);
+    reply += ",\"pausedRequests\":[";
+    appendAppInfoArray(reply, displayInfo.getPausedAppList(), true);
+    reply += "],\"activeRequests\":[";
+    appendAppInfoArray(reply, displayInfo.getActiveAppList(), true);
+    reply += "]}]}";
+    return reply;
+}
+
+/*
+ * Functionality of this method:
+ * ->Sends the changes since the last snapshot to the delta subscribers of the display and takes a new one.
+ * ->Clients drop the "removed" entryIds, then append the entries of "appendedPaused" and "appendedActive"
+ *   to the respective lists. An entry moved between the lists shows up in both, with the same entryId.
+ * ->A sequence other than the last one plus one means a missed update, the client subscribes again.
+ */
+void AudioFocusManager::broadcastStatusDelta(int displayId, DisplayFocusState& displayInfo)
+{
+    CLSError lserror;
+    std::vector<uint64_t> removedEntryIds;
+    std::vector<const APP_INFO_T*> appendedActive;
+    std::vector<const APP_INFO_T*> appendedPaused;
+    displayInfo.getStatusDelta(removedEntryIds, appendedActive, appendedPaused);
+
+    std::string reply = "{\"returnValue\":true,\"subscribed\":true,\"delta\":true,\"sequence\":";
+    reply += std::to_string(displayInfo.getStatusSequence() + 1);
+    reply += ",\"displayId\":";
+    reply += std::to_string(displayId);
+    reply += ",\"removed\":[";
+    for (size_t index = 0; index < removedEntryIds.size(); index++)
+    {
+        if (index)
+            reply += ',';
+        reply += std::to_string(removedEntryIds[index]);
+    }
+    reply += "],\"appendedPaused\":[";
+    for (size_t index = 0; index < appendedPaused.size(); index++)
+    {
+        if (index)
+            reply += ',';
+        appendAppInfo(reply, *appendedPaused[index], true);
+    }
+    reply += "],\"appendedActive\":[";
+    for (size_t index = 0; index < appendedActive.size(); index++)
+    {
+        if (index)
+            reply += ',';
+        appendAppInfo(reply, *appendedActive[index], true);
+    }
+    reply += "]}";
+    displayInfo.takeStatusSnapshot();
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"broadcastStatusDelta: reply message to subscriber: %s", reply.c_str());
+
+    if (!LSSubscriptionReply(GetLSService(), getStatusSubscriptionKey(displayId, true).c_str(), reply.c_str(), &lserror))
+    {
+        lserror.Print(__FUNCTION__, __LINE__);
+    }
+}
+
+/*
+ * Functionality of this method:
+ * ->Marks the status of displayId as changed. The subscribers are notified once for all
+ *   the changes of the current main loop iteration, or of the configured window.
+ */
+void AudioFocusManager::scheduleStatusBroadcast(int displayId)
+{
+    mDirtyDisplays.insert(displayId);
+    if (mBroadcastSourceId)
+        return;
+    if (mBroadcastCoalesceMs)
+        mBroadcastSourceId = g_timeout_add(mBroadcastCoalesceMs, AudioFocusManager::_flushStatusBroadcasts, this);
+    else
+        mBroadcastSourceId = g_idle_add(AudioFocusManager::_flushStatusBroadcasts, this);
+}
+
+void AudioFocusManager::flushStatusBroadcasts()
+{
+    if (mBroadcastSourceId)
+    {
+        g_source_remove(mBroadcastSourceId);
+        mBroadcastSourceId = 0;
+    }
+    if (mDirtyDisplays.empty())
+        return;
+    std::set<int> dirtyDisplays;
+    dirtyDisplays.swap(mDirtyDisplays);
+    for (int displayId : dirtyDisplays)
+        broadcastStatusToSubscribers(displayId);
+
+    //All the displays are serialized for this key, only when it is subscribed to
+    if (!hasStatusSubscribers(AF_GET_STATUS_ALL_DISPLAYS_KEY))
+        return;
+    CLSError lserror;
+    std::string reply = getAllDisplaysStatusReply(true);
+    if (!LSSubscriptionReply(GetLSService(), AF_GET_STATUS_ALL_DISPLAYS_KEY, reply.c_str(), &lserror))
+    {
+        lserror.Print(__FUNCTION__, __LINE__);
+    }
+}
+
 void AudioFocusManager::broadcastStatusToSubscribers(int displayId)
 {
     CLSError lserror;
-    pbnjson::JValue jsonObject = pbnjson::JObject();
-    jsonObject.put("returnValue",true);
-    jsonObject.put("subscribed",true);
-    jsonObject.put("audioFocusStatus", getStatusPayload(displayId));
-    std::string reply = jsonObject.stringify();
+    std::string reply = getStatusReply(displayId, true);
     PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"broadcastStatusToSubscribers: reply message to subscriber: %s", \
             reply.c_str());
 
-    if (!LSSubscriptionReply(GetLSService(), AF_API_GET_STATUS, reply.c_str(), &lserror))
+    if (!LSSubscriptionReply(GetLSService(), getStatusSubscriptionKey(displayId).c_str(), reply.c_str(), &lserror))
     {
         lserror.Print(__FUNCTION__, __LINE__);
     }
+    //The delta and the snapshot it advances are only computed for someone
+    DisplayFocusState& displayInfo = mFocusEngine.getDisplay(displayId);
+    if (!displayInfo.isStatusSnapshotCurrent() && hasStatusSubscribers(getStatusSubscriptionKey(displayId, true)))
+        broadcastStatusDelta(displayId, displayInfo);
+}
+
+bool AudioFocusManager::hasStatusSubscribers(const std::string& key)
+{
+    return LSSubscriptionGetHandleSubscribersCount(GetLSService(), key.c_str()) > 0;
 }
 
 /*
 Functionality of this method:
 ->This is a utility function used for dealing with subscription list.
-->Based on the operation received it does the following functionalities:-
-    operation 's' : Signals the corresponding application with the signalMessage(AF_LOST/AF_PAUSE/AF_GRANTED) passed to it.
+->It commits all the application notifications of one focus decision, in the order they were queued.
+  Each notification goes to the subscription its entry was granted with, found from its focusHandle,
+  so an application with several entries only hears about each one on its own call.
+->Based on the operation of each notification it does the following functionalities:-
+    operation 's' : Signals the corresponding application with the event(AF_LOST/AF_PAUSE/AF_GRANTED) passed to it.
                     It will send events like AF_LOST/AF_PAUSE to the current running application.
                     It will send resume(AF_GRANTED) event to the paused application.
-    operation 'r' : Removes the subscription for the respective applicationId passed.
-    operation 'c' : This is for checking whether the corresponding applicationId is subscribed or not.
+    operation 'n' : Signals the application and forgets the entry.
+    operation 'r' : Forgets the entry.
+  A subscription is removed once it has no entry left.
+->Removed subscriptions are dropped from AF_SUBSCRIPTION_LIST in a single pass at the end.
 */
-void AudioFocusManager::manageAppSubscription(const std::string& applicationId, const std::string& payload, const char operation)
+void AudioFocusManager::manageAppSubscription(const AppNotificationList& notifications)
 {
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"notifyApplication: applicationId:%s payload:%s operation:%c",\
-        applicationId.c_str(), payload.c_str(), operation);
-    std::string subscribed_appId;
-    pbnjson::JDomParser parser;
-    LSSubscriptionIter *iter = NULL;
-    bool retValAcquire = false;
-    CLSError lserror;
-    retValAcquire = LSSubscriptionAcquire(GetLSService(), "AFSubscriptionList", &iter, &lserror);
-    if(retValAcquire)
+    std::vector<LSMessage*> removedSubscriptions;
+    for (const auto& notification : notifications)
     {
-        while(LSSubscriptionHasNext(iter))
+        const std::string& applicationId = mFocusEngine.getSymbolTable().getName(notification.appId);
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription: applicationId:%s event:%s operation:%c",\
+            applicationId.c_str(), notification.event, notification.operation);
+        auto itHandle = mHandleSubscriptions.find(notification.focusHandle);
+        if (itHandle == mHandleSubscriptions.end())
         {
-            LSMessage *iter_message = LSSubscriptionNext(iter);
-            const char* msgJsonArgument = LSMessageGetPayload(iter_message);
-            if (!parser.parse(msgJsonArgument, pbnjson::JSchemaFragment("{}")))
-            {
-                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"Not a valid json payload");
-                continue;
-            }
-            pbnjson::JValue msgJsonSubArgument = parser.getDom();
-            const char* appId = LSMessageGetApplicationID(iter_message);
-            if (appId == NULL)
+            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription: no subscription for %s", applicationId.c_str());
+            continue;
+        }
+        LSMessage *subscription = itHandle->second;
+        auto itSubscription = mFocusSubscriptions.find(subscription);
+        if (itSubscription == mFocusSubscriptions.end())
+            continue;
+        FOCUS_SUBSCRIPTION_T& focusSubscription = itSubscription->second;
+        uint64_t eventFocusHandle = focusSubscription.batch ? notification.focusHandle : 0;
+        bool removeEntry = false;
+        switch(notification.operation)
+        {
+            case 's':
+                    sendApplicationResponse(GetLSService(), subscription, notification.event, eventFocusHandle);
+                    break;
+
+            case 'n':
+                    sendApplicationResponse(GetLSService(), subscription, notification.event, eventFocusHandle);
+                    removeEntry = true;
+                    break;
+
+            case 'r':
+                    removeEntry = true;
+                    break;
+
+            default:
+                    PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription: INVALID OPTION");
+                    break;
+        }
+        if (removeEntry)
+        {
+            mHandleSubscriptions.erase(itHandle);
+            std::vector<uint64_t>& focusHandles = focusSubscription.focusHandles;
+            focusHandles.erase(std::remove(focusHandles.begin(), focusHandles.end(), notification.focusHandle),
+                focusHandles.end());
+            if (focusHandles.empty())
             {
-                appId = LSMessageGetSenderServiceName(iter_message);
+                removedSubscriptions.push_back(subscription);
+                mFocusSubscriptions.erase(itSubscription);
             }
-            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription App id :%s", appId);
-            if((appId != NULL) && !((applicationId).compare(appId)))
-            {
-                switch(operation)
-                {
-                    case 's':
-                            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription send response:%s",\
-                                appId);
-                            sendApplicationResponse(GetLSService(), iter_message, payload);
-                            break;
-
-                    case 'n':
-                            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription:send response and remove %s",\
-                                appId);
-                            sendApplicationResponse(GetLSService(), iter_message, payload);
-                            LSSubscriptionRemove(iter);
-                            break;
-
-                    case 'r':
-                            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription:remove %s",\
-                                appId);
-                            LSSubscriptionRemove(iter);
-                            break;
-                    case 'c':
-                            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription: Check %s",\
-                                appId);
-                            break;
-
-                    default:
-                            PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription: INVALID OPTION");
-                            break;
-                }
+        }
+    }
+    if (removedSubscriptions.empty())
+        return;
 
-                lserror.Print(__FUNCTION__,__LINE__);
-                break;
-            }
+    LSSubscriptionIter *iter = NULL;
+    CLSError lserror;
+    if (LSSubscriptionAcquire(GetLSService(), AF_SUBSCRIPTION_LIST, &iter, &lserror))
+    {
+        while (LSSubscriptionHasNext(iter))
+        {
+            LSMessage *subscription = LSSubscriptionNext(iter);
+            if (std::find(removedSubscriptions.begin(), removedSubscriptions.end(), subscription) != removedSubscriptions.end())
+                LSSubscriptionRemove(iter);
         }
         LSSubscriptionRelease(iter);
     }
     else
+    {
         PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT,"manageAppSubscription: failed in LSSubscriptionAcquire");
+        lserror.Print(__FUNCTION__, __LINE__);
+    }
+    for (auto subscription : removedSubscriptions)
+        LSMessageUnref(subscription);
 }
 
-void AudioFocusManager::sendApplicationResponse(LSHandle *serviceHandle, LSMessage *message, const std::string& payload)
+/*
+Functionality of this method:
+->Keeps a reference of a requestFocus or requestFocusBatch subscription message, and routes
+  the events of the entries it was granted to it.
+*/
+void AudioFocusManager::addFocusSubscription(LSMessage *message, const std::vector<uint64_t>& focusHandles, bool batch)
+{
+    LSMessageRef(message);
+    FOCUS_SUBSCRIPTION_T& focusSubscription = mFocusSubscriptions[message];
+    focusSubscription.focusHandles = focusHandles;
+    focusSubscription.batch = batch;
+    for (uint64_t focusHandle : focusHandles)
+        mHandleSubscriptions[focusHandle] = message;
+}
+
+/*
+Functionality of this method:
+->Drops the reference kept for a cancelled requestFocus or requestFocusBatch subscription message.
+*/
+void AudioFocusManager::removeFocusSubscription(LSMessage *message)
+{
+    auto itSubscription = mFocusSubscriptions.find(message);
+    if (itSubscription == mFocusSubscriptions.end())
+        return;
+    for (uint64_t focusHandle : itSubscription->second.focusHandles)
+        mHandleSubscriptions.erase(focusHandle);
+    mFocusSubscriptions.erase(itSubscription);
+    LSMessageUnref(message);
+}
+
+/*
+ * Functionality of this method:
+ * ->Sends the reply of a focus result. The set of results is fixed, their replies
+ *   are string literals, so the common case needs no json work at all.
+ */
+void AudioFocusManager::sendApplicationResponse(LSHandle *serviceHandle, LSMessage *message, const char* result,
+    uint64_t focusHandle)
 {
-    pbnjson::JValue replyObject = pbnjson::Object();
-    replyObject.put("returnValue", true);
-    if (payload != "AF_SUCCESSFULLY_RELEASED")
-        replyObject.put("subscribed", true);
-    replyObject.put("result", payload.c_str());
-    std::string reply = replyObject.stringify();
-    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"sendApplicationResponse: %s", reply.c_str());
-    LSMessageResponse(serviceHandle, message, reply.c_str(), eLSReply, false);
+    const char* reply = nullptr;
+    std::string builtReply;
+    for (const auto& focusResultReply : focusResultReplies)
+    {
+        if (strcmp(focusResultReply.result, result) == 0)
+        {
+            reply = focusResultReply.reply;
+            break;
+        }
+    }
+    if (reply == nullptr)
+    {
+        builtReply = "{\"returnValue\":true,\"subscribed\":true,\"result\":";
+        appendJsonString(builtReply, result, strlen(result));
+        builtReply += '}';
+        reply = builtReply.c_str();
+    }
+    //The reply to requestFocus also carries the handle of the entry, written over the closing brace
+    char handleReply[AF_FOCUS_HANDLE_REPLY_SIZE];
+    if (focusHandle)
+    {
+        int written = snprintf(handleReply, sizeof(handleReply), "%.*s,\"focusHandle\":%llu}", \
+            (int) strlen(reply) - 1, reply, (unsigned long long) focusHandle);
+        if (written > 0 && (size_t) written < sizeof(handleReply))
+            reply = handleReply;
+        else
+        {
+            builtReply.assign(reply, strlen(reply) - 1);
+            builtReply += ",\"focusHandle\":";
+            builtReply += std::to_string(focusHandle);
+            builtReply += '}';
+            reply = builtReply.c_str();
+        }
+    }
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"sendApplicationResponse: %s", reply);
+    LSMessageResponse(serviceHandle, message, reply, eLSReply, false);
 }
 
 /*
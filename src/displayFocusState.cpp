@@ -0,0 +1,254 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "displayFocusState.h"
+#include <iterator>
+#include <algorithm>
+
+//Shared by every display, so the latest generation also stands for the state of all of them
+static uint64_t lastGeneration = 1;
+
+uint64_t DisplayFocusState::getLastGeneration()
+{
+    return lastGeneration;
+}
+
+AppInfoList::iterator DisplayFocusState::addActiveApp(const APP_INFO_T& appInfo)
+{
+    auto itApp = mActiveAppList.insert(mActiveAppList.end(), appInfo);
+    itApp->isPaused = false;
+    itApp->entryId = itApp->listOrder = mNextListOrder++;
+    mAppIndex[itApp->appId].push_back(itApp);
+    mEntryIndex[itApp->entryId] = itApp;
+    countRequestType(mActiveRequestTypeCount, mActiveRequestTypeMask, itApp->requestTypeId, true);
+    mGeneration = ++lastGeneration;
+    return itApp;
+}
+
+AppInfoList::iterator DisplayFocusState::removeActiveApp(AppInfoList::iterator itActive)
+{
+    countRequestType(mActiveRequestTypeCount, mActiveRequestTypeMask, itActive->requestTypeId, false);
+    unindexApp(itActive);
+    mGeneration = ++lastGeneration;
+    return mActiveAppList.erase(itActive);
+}
+
+AppInfoList::iterator DisplayFocusState::removePausedApp(AppInfoList::iterator itPaused)
+{
+    countRequestType(mPausedRequestTypeCount, mPausedRequestTypeMask, itPaused->requestTypeId, false);
+    unindexApp(itPaused);
+    mGeneration = ++lastGeneration;
+    return mPausedAppList.erase(itPaused);
+}
+
+AppInfoList::iterator DisplayFocusState::removeApp(AppInfoList::iterator itApp)
+{
+    return itApp->isPaused ? removePausedApp(itApp) : removeActiveApp(itApp);
+}
+
+AppInfoList::iterator DisplayFocusState::pauseActiveApp(AppInfoList::iterator itActive)
+{
+    auto itNext = std::next(itActive);
+    countRequestType(mActiveRequestTypeCount, mActiveRequestTypeMask, itActive->requestTypeId, false);
+    countRequestType(mPausedRequestTypeCount, mPausedRequestTypeMask, itActive->requestTypeId, true);
+    itActive->isPaused = true;
+    itActive->listOrder = mNextListOrder++;
+    mPausedAppList.splice(mPausedAppList.end(), mActiveAppList, itActive);
+    mGeneration = ++lastGeneration;
+    return itNext;
+}
+
+AppInfoList::iterator DisplayFocusState::resumePausedApp(AppInfoList::iterator itPaused)
+{
+    auto itNext = std::next(itPaused);
+    countRequestType(mPausedRequestTypeCount, mPausedRequestTypeMask, itPaused->requestTypeId, false);
+    countRequestType(mActiveRequestTypeCount, mActiveRequestTypeMask, itPaused->requestTypeId, true);
+    itPaused->isPaused = false;
+    itPaused->listOrder = mNextListOrder++;
+    mActiveAppList.splice(mActiveAppList.end(), mPausedAppList, itPaused);
+    mGeneration = ++lastGeneration;
+    return itNext;
+}
+
+/*
+ * Functionality of this method:
+ * ->The counters are rebuilt from the remaining entries, as ids can be swapped by the new policy.
+ * ->The list order is kept, so the entries stay where they were for the delta subscribers.
+ */
+void DisplayFocusState::remapRequestTypes(const std::vector<int>& requestTypeMap, std::vector<APP_INFO_T>& removedApps)
+{
+    std::fill(std::begin(mActiveRequestTypeCount), std::end(mActiveRequestTypeCount), 0);
+    std::fill(std::begin(mPausedRequestTypeCount), std::end(mPausedRequestTypeCount), 0);
+    mActiveRequestTypeMask = mPausedRequestTypeMask = 0;
+    for (AppInfoList* appList : {&mActiveAppList, &mPausedAppList})
+    {
+        for (auto itApp = appList->begin(); itApp != appList->end();)
+        {
+            int requestTypeId = AF_INVALID_REQUEST_TYPE;
+            if (itApp->requestTypeId >= 0 && itApp->requestTypeId < (int) requestTypeMap.size())
+                requestTypeId = requestTypeMap[itApp->requestTypeId];
+            if (requestTypeId == AF_INVALID_REQUEST_TYPE)
+            {
+                removedApps.push_back(*itApp);
+                unindexApp(itApp);
+                itApp = appList->erase(itApp);
+                continue;
+            }
+            itApp->requestTypeId = requestTypeId;
+            if (itApp->isPaused)
+                countRequestType(mPausedRequestTypeCount, mPausedRequestTypeMask, requestTypeId, true);
+            else
+                countRequestType(mActiveRequestTypeCount, mActiveRequestTypeMask, requestTypeId, true);
+            ++itApp;
+        }
+    }
+    mGeneration = ++lastGeneration;
+}
+
+const std::string& DisplayFocusState::setCachedStatus(std::string status)
+{
+    mCachedStatus = std::move(status);
+    mCachedStatusGeneration = mGeneration;
+    return mCachedStatus;
+}
+
+bool DisplayFocusState::findApp(int appId, int requestTypeId, AppInfoList::iterator& itApp)
+{
+    auto itIndex = mAppIndex.find(appId);
+    if (itIndex == mAppIndex.end())
+        return false;
+    for (const auto& itEntry : itIndex->second)
+    {
+        if (itEntry->requestTypeId == requestTypeId)
+        {
+            itApp = itEntry;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Functionality of this method:
+ * ->Since every insertion stamps listOrder, the smallest stamp is the first entry in list order.
+ */
+bool DisplayFocusState::findFirstApp(int appId, AppInfoList::iterator& itApp, int streamType)
+{
+    auto itIndex = mAppIndex.find(appId);
+    if (itIndex == mAppIndex.end())
+        return false;
+    bool found = false;
+    for (const auto& itEntry : itIndex->second)
+    {
+        if (streamType != -1 && itEntry->streamType != streamType)
+            continue;
+        if (!found || (itEntry->isPaused && !itApp->isPaused) ||
+            (itEntry->isPaused == itApp->isPaused && itEntry->listOrder < itApp->listOrder))
+        {
+            itApp = itEntry;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool DisplayFocusState::findEntry(uint64_t entryId, AppInfoList::iterator& itApp)
+{
+    auto itIndex = mEntryIndex.find(entryId);
+    if (itIndex == mEntryIndex.end())
+        return false;
+    itApp = itIndex->second;
+    return true;
+}
+
+/*
+ * Functionality of this method:
+ * ->Both lists are in listOrder order and every insertion takes a new listOrder, so the entries
+ *   appended since the snapshot are the tails with a listOrder past the snapshot bound.
+ * ->Snapshot entries whose listOrder is no longer found were removed, or moved to the other list.
+ */
+void DisplayFocusState::getStatusDelta(std::vector<uint64_t>& removedEntryIds,
+                                       std::vector<const APP_INFO_T*>& appendedActive,
+                                       std::vector<const APP_INFO_T*>& appendedPaused) const
+{
+    std::vector<uint64_t> keptListOrders;
+    keptListOrders.reserve(mSnapshotEntries.size());
+    for (const auto& appInfo : mActiveAppList)
+    {
+        if (appInfo.listOrder < mSnapshotListOrderBound)
+            keptListOrders.push_back(appInfo.listOrder);
+        else
+            appendedActive.push_back(&appInfo);
+    }
+    for (const auto& appInfo : mPausedAppList)
+    {
+        if (appInfo.listOrder < mSnapshotListOrderBound)
+            keptListOrders.push_back(appInfo.listOrder);
+        else
+            appendedPaused.push_back(&appInfo);
+    }
+    std::sort(keptListOrders.begin(), keptListOrders.end());
+    auto itKept = keptListOrders.begin();
+    for (const auto& entry : mSnapshotEntries)
+    {
+        if (itKept != keptListOrders.end() && *itKept == entry.first)
+            ++itKept;
+        else
+            removedEntryIds.push_back(entry.second);
+    }
+}
+
+uint64_t DisplayFocusState::takeStatusSnapshot()
+{
+    mSnapshotEntries.clear();
+    for (const auto& appInfo : mActiveAppList)
+        mSnapshotEntries.emplace_back(appInfo.listOrder, appInfo.entryId);
+    for (const auto& appInfo : mPausedAppList)
+        mSnapshotEntries.emplace_back(appInfo.listOrder, appInfo.entryId);
+    std::sort(mSnapshotEntries.begin(), mSnapshotEntries.end());
+    mSnapshotListOrderBound = mNextListOrder;
+    mSnapshotGeneration = mGeneration;
+    return ++mStatusSequence;
+}
+
+void DisplayFocusState::unindexApp(AppInfoList::iterator itApp)
+{
+    mEntryIndex.erase(itApp->entryId);
+    auto itIndex = mAppIndex.find(itApp->appId);
+    if (itIndex == mAppIndex.end())
+        return;
+    std::vector<AppInfoList::iterator>& entries = itIndex->second;
+    for (auto itEntry = entries.begin(); itEntry != entries.end(); ++itEntry)
+    {
+        if (*itEntry == itApp)
+        {
+            entries.erase(itEntry);
+            break;
+        }
+    }
+    if (entries.empty())
+        mAppIndex.erase(itIndex);
+}
+
+void DisplayFocusState::countRequestType(unsigned int *count, uint32_t& mask, int requestTypeId, bool add)
+{
+    if (add && count[requestTypeId]++ == 0)
+        mask |= REQUEST_TYPE_BIT(requestTypeId);
+    else if (!add && --count[requestTypeId] == 0)
+        mask &= ~REQUEST_TYPE_BIT(requestTypeId);
+}
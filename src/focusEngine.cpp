@@ -0,0 +1,402 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "focusEngine.h"
+#include "log.h"
+
+FocusEngine::FocusEngine(int displayCount) : mDisplayInfo(displayCount)
+{
+}
+
+/*
+ * Functionality of this method:
+ * ->Once swapped in, the entries take the ids of their request type in the new policy.
+ *   Entries of a request type the new policy no longer has are lost, the other ones are
+ *   re-evaluated against the new action table.
+ */
+void FocusEngine::replacePolicy(FocusPolicy& focusPolicy, AppNotificationList& notifications,
+    std::set<int>& changedDisplays)
+{
+    std::vector<int> requestTypeMap;
+    for (int requestTypeId = 0; requestTypeId < mFocusPolicy.getRequestTypeCount(); requestTypeId++)
+        requestTypeMap.push_back(focusPolicy.getRequestTypeId(mFocusPolicy.getRequestTypeName(requestTypeId)));
+    std::swap(mFocusPolicy, focusPolicy);
+
+    for (int displayId = 0; validateDisplayId(displayId); displayId++)
+    {
+        DisplayFocusState& displayInfo = mDisplayInfo[displayId];
+        if (!(displayInfo.getActiveRequestTypeMask() | displayInfo.getPausedRequestTypeMask()))
+            continue;
+        std::vector<APP_INFO_T> removedApps;
+        displayInfo.remapRequestTypes(requestTypeMap, removedApps);
+        for (const auto& appInfo : removedApps)
+        {
+            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "replacePolicy: request type of %s removed, send AF_LOST", \
+                mSymbolTable.getName(appInfo.appId).c_str());
+            notifications.push_back({appInfo.appId, "AF_LOST", 'n', makeFocusHandle(displayId, appInfo.entryId)});
+        }
+        reevaluateDisplayFocus(displayId, notifications);
+        changedDisplays.insert(displayId);
+    }
+}
+
+/*
+ * Functionality of this method:
+ * ->An active entry stays active if it mixes with the active entries before it, else it is paused.
+ * ->A paused entry is resumed once it mixes with every active entry, as in pausedAppToActive.
+ *   Nothing is lost here, so a later change of the policy can undo the pauses.
+ */
+void FocusEngine::reevaluateDisplayFocus(const int& displayId, AppNotificationList& notifications)
+{
+    DisplayFocusState& displayInfo = mDisplayInfo[displayId];
+    size_t pausedCount = displayInfo.getPausedAppList().size();
+    uint32_t activeRequestTypeMask = 0;
+    for (auto itActive = displayInfo.activeBegin(); itActive != displayInfo.activeEnd();)
+    {
+        int requestTypeId = itActive->requestTypeId;
+        if (isMixedWithActive(requestTypeId, activeRequestTypeMask))
+        {
+            activeRequestTypeMask |= REQUEST_TYPE_BIT(requestTypeId);
+            ++itActive;
+            continue;
+        }
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "reevaluateDisplayFocus: send AF_PAUSE to %s", \
+            mSymbolTable.getName(itActive->appId).c_str());
+        notifications.push_back({itActive->appId, "AF_PAUSE", 's', makeFocusHandle(displayId, itActive->entryId)});
+        itActive = displayInfo.pauseActiveApp(itActive);
+    }
+    //Paused in the loop above are at the end of the list and are not mixed, stop before them
+    auto itPaused = displayInfo.pausedBegin();
+    for (size_t index = 0; index < pausedCount; index++)
+    {
+        if (!isMixedWithActive(itPaused->requestTypeId, displayInfo.getActiveRequestTypeMask()) || \
+            !isIncomingPairRequestTypeActive(itPaused->requestTypeId, displayInfo))
+        {
+            ++itPaused;
+            continue;
+        }
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "reevaluateDisplayFocus: send AF_GRANTED to %s", \
+            mSymbolTable.getName(itPaused->appId).c_str());
+        notifications.push_back({itPaused->appId, "AF_GRANTED", 's', makeFocusHandle(displayId, itPaused->entryId)});
+        itPaused = displayInfo.resumePausedApp(itPaused);
+    }
+}
+
+//The request type can be active alongside all of activeRequestTypeMask, without pausing or losing any
+bool FocusEngine::isMixedWithActive(int requestTypeId, uint32_t activeRequestTypeMask)
+{
+    FEASIBILITY_OUTCOME_T outcome = mFocusPolicy.getFeasibility(activeRequestTypeMask, 0, requestTypeId);
+    return outcome.granted && !(outcome.pauseMask | outcome.lostActiveMask);
+}
+
+void FocusEngine::setDisplayCount(int displayCount)
+{
+    mDisplayInfo = DisplayInfoTable(displayCount);
+}
+
+/*
+Functionality of this method:
+Validating the display Id against the number of displays of the focus state table
+*/
+bool FocusEngine::validateDisplayId(int displayId) const
+{
+    return displayId >= 0 && displayId < (int) mDisplayInfo.size();
+}
+
+/*
+ * Functionality of this method:
+ * ->Applies one focus request of appId to the current state of the display.
+ * ->On grant the new entry is added to the active list and the notifications of the affected
+ *   applications are queued, they are left to the caller to send.
+ * ->result is the reply for the requesting application, focusHandle identifies its entry when
+ *   granted now or already. displayId and requestTypeId are checked by the caller.
+ */
+bool FocusEngine::requestFocus(const int& displayId, const char* appId, int requestTypeId,
+    const std::string& streamType, AppNotificationList& notifications, const char*& result, uint64_t& focusHandle)
+{
+    if (checkGrantedAlready(mSymbolTable.find(appId), displayId, requestTypeId, focusHandle))
+    {
+        result = "AF_GRANTEDALREADY";
+        return false;
+    }
+    if (!checkFeasibility(displayId, requestTypeId, notifications))
+    {
+        result = "AF_CANNOTBEGRANTED";
+        return false;
+    }
+    uint64_t entryId = updateDisplayActiveAppList(displayId, mSymbolTable.intern(appId), requestTypeId,
+        mSymbolTable.intern(streamType));
+    focusHandle = makeFocusHandle(displayId, entryId);
+    result = "AF_GRANTED";
+    return true;
+}
+
+/*
+Functionality of this method:
+->Checks whether the incoming request is duplicate request or not.
+->If it is a duplicate request sends AF_GRANTEDALREADY event to the app.
+*/
+bool FocusEngine::checkGrantedAlready(int applicationId, const int& displayId, int requestTypeId,
+    uint64_t& focusHandle)
+{
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkGrantedAlready for appId:%s displayId:%d requestType:%s",\
+        mSymbolTable.getName(applicationId).c_str(), displayId, mFocusPolicy.getRequestTypeName(requestTypeId).c_str());
+    if (applicationId == AF_INVALID_SYMBOL)
+        return false;
+    AppInfoList::iterator itApp;
+    if (mDisplayInfo[displayId].findApp(applicationId, requestTypeId, itApp))
+    {
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkGrantedAlready: AF_GRANTEDALREADY in %s list:%s", \
+            itApp->isPaused ? "paused" : "active", mSymbolTable.getName(applicationId).c_str());
+        focusHandle = makeFocusHandle(displayId, itApp->entryId);
+        return true;
+    }
+    return false;
+}
+
+/*Functionality of this method:
+ * To check if active request types in the requesting display has any request which will not grant the new request type*/
+bool FocusEngine::checkFeasibility(const int& displayId, int newRequestTypeId, AppNotificationList& notifications)
+{
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility for displayId:%d newRequestType:%s",\
+        displayId, mFocusPolicy.getRequestTypeName(newRequestTypeId).c_str());
+    DisplayFocusState& curdisplayInfo = mDisplayInfo[displayId];
+    FEASIBILITY_OUTCOME_T outcome = mFocusPolicy.getFeasibility(curdisplayInfo.getActiveRequestTypeMask(), \
+        curdisplayInfo.getPausedRequestTypeMask(), newRequestTypeId);
+    if (!outcome.granted)
+    {
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: newRequestType cannot be granted");
+        return false;
+    }
+    //Only the request types marked in the outcome are affected, skip the list walk otherwise
+    if (outcome.pauseMask | outcome.lostActiveMask)
+    {
+        for (auto itActive = curdisplayInfo.activeBegin(); itActive != curdisplayInfo.activeEnd();)
+        {
+            uint32_t requestTypeBit = REQUEST_TYPE_BIT(itActive->requestTypeId);
+            if (outcome.pauseMask & requestTypeBit)
+            {
+                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: send AF_PAUSE to %s", \
+                    mSymbolTable.getName(itActive->appId).c_str());
+                notifications.push_back({itActive->appId, "AF_PAUSE", 's',
+                    makeFocusHandle(displayId, itActive->entryId)});
+                itActive = curdisplayInfo.pauseActiveApp(itActive);
+            }
+            else if (outcome.lostActiveMask & requestTypeBit)
+            {
+                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: send AF_LOST to %s", \
+                    mSymbolTable.getName(itActive->appId).c_str());
+                notifications.push_back({itActive->appId, "AF_LOST", 'n',
+                    makeFocusHandle(displayId, itActive->entryId)});
+                itActive = curdisplayInfo.removeActiveApp(itActive);
+            }
+            else
+                ++itActive;
+        }
+    }
+    //Paused apps can only be lost, already paused apps of a paused request type are kept
+    if (outcome.lostPausedMask)
+    {
+        for (auto itPaused = curdisplayInfo.pausedBegin(); itPaused != curdisplayInfo.pausedEnd();)
+        {
+            if (outcome.lostPausedMask & REQUEST_TYPE_BIT(itPaused->requestTypeId))
+            {
+                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"checkFeasibility: send AF_LOST to paused app %s", \
+                    mSymbolTable.getName(itPaused->appId).c_str());
+                //The entry is gone, its handle is forgotten as for a lost active app
+                notifications.push_back({itPaused->appId, "AF_LOST", 'n',
+                    makeFocusHandle(displayId, itPaused->entryId)});
+                itPaused = curdisplayInfo.removePausedApp(itPaused);
+            }
+            else
+                ++itPaused;
+        }
+    }
+    return true;
+}
+
+/*Functionality of this methos:
+ * -> Update the display active app list if display already present
+ *  ->Create new display Info and update active app list
+ */
+uint64_t FocusEngine::updateDisplayActiveAppList(const int& displayId, int appId, int requestTypeId, int streamType)
+{
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"updateDisplayActiveAppList: displayId: %d", displayId);
+    APP_INFO_T newAppInfo;
+    newAppInfo.appId = appId;
+    newAppInfo.requestTypeId = requestTypeId;
+    newAppInfo.streamType = streamType;
+    return mDisplayInfo[displayId].addActiveApp(newAppInfo)->entryId;
+}
+
+/*
+ * Functionality of this method:
+ * ->Removes an entry of the application from the display and resumes the paused applications
+ *   it was holding back. Notifications are queued for the caller to send.
+ * ->With a focusHandle that exact entry is removed, if it belongs to the application.
+ *   Otherwise the first entry of streamType is, nothing is released if the application holds
+ *   no entry of this stream.
+ */
+bool FocusEngine::releaseFocus(const int& displayId, const char* appId, const std::string* streamType,
+    uint64_t focusHandle, AppNotificationList& notifications)
+{
+    if (!validateDisplayId(displayId))
+        return false;
+    DisplayFocusState& displayInfo = mDisplayInfo[displayId];
+    int appIdSymbol = mSymbolTable.find(appId);
+    int streamTypeSymbol = streamType ? mSymbolTable.find(*streamType) : AF_INVALID_SYMBOL;
+    AppInfoList::iterator itApp;
+    if (focusHandle)
+    {
+        int handleDisplayId = -1;
+        uint64_t entryId = 0;
+        if (!splitFocusHandle(focusHandle, handleDisplayId, entryId) || handleDisplayId != displayId || \
+            !displayInfo.findEntry(entryId, itApp) || itApp->appId != appIdSymbol)
+            return false;
+    }
+    else if (streamType)
+    {
+        if (streamTypeSymbol == AF_INVALID_SYMBOL || !displayInfo.findFirstApp(appIdSymbol, itApp, streamTypeSymbol))
+            return false;
+    }
+    else if (!displayInfo.findFirstApp(appIdSymbol, itApp))
+        return false;
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "releaseFocus: Removing appId: %s Request type: %s from %s list", \
+        mSymbolTable.getName(appIdSymbol).c_str(), mFocusPolicy.getRequestTypeName(itApp->requestTypeId).c_str(), \
+        itApp->isPaused ? "paused" : "active");
+    notifications.push_back({appIdSymbol, "AF_RELEASED", 'r', makeFocusHandle(displayId, itApp->entryId)});
+    removeFocusEntry(displayId, itApp, notifications);
+    return true;
+}
+
+//Removes the entry, an active one lets the paused applications it was holding back resume
+void FocusEngine::removeFocusEntry(const int& displayId, AppInfoList::iterator itApp,
+    AppNotificationList& notifications)
+{
+    DisplayFocusState& displayInfo = mDisplayInfo[displayId];
+    if (itApp->isPaused)
+    {
+        displayInfo.removePausedApp(itApp);
+        return;
+    }
+    int requestTypeId = itApp->requestTypeId;
+    displayInfo.removeActiveApp(itApp);
+    pausedAppToActive(displayId, requestTypeId, notifications);
+}
+
+//Only the entries owned by appId are removed, a handle of another application is ignored
+void FocusEngine::cancelFocus(const char* appId, const std::vector<uint64_t>& focusHandles,
+    AppNotificationList& notifications, std::set<int>& changedDisplays)
+{
+    int appIdSymbol = mSymbolTable.find(appId);
+    if (appIdSymbol == AF_INVALID_SYMBOL)
+        return;
+    for (uint64_t focusHandle : focusHandles)
+    {
+        int displayId = -1;
+        uint64_t entryId = 0;
+        AppInfoList::iterator itApp;
+        if (!splitFocusHandle(focusHandle, displayId, entryId))
+            continue;
+        if (!validateDisplayId(displayId) || !mDisplayInfo[displayId].findEntry(entryId, itApp) || \
+            itApp->appId != appIdSymbol)
+            continue;
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "%s app Killed: Removing appId: %s Request type: %s", \
+            itApp->isPaused ? "Paused" : "Active", appId, \
+            mFocusPolicy.getRequestTypeName(itApp->requestTypeId).c_str());
+        removeFocusEntry(displayId, itApp, notifications);
+        changedDisplays.insert(displayId);
+    }
+}
+
+const APP_INFO_T* FocusEngine::getFocusEntry(uint64_t focusHandle)
+{
+    int displayId = -1;
+    uint64_t entryId = 0;
+    AppInfoList::iterator itApp;
+    if (!splitFocusHandle(focusHandle, displayId, entryId) || !validateDisplayId(displayId) || \
+        !mDisplayInfo[displayId].findEntry(entryId, itApp))
+        return nullptr;
+    return &*itApp;
+}
+
+//Handles carry the displayId in their low bits, the entryId plus one above so that 0 is never a handle
+uint64_t FocusEngine::makeFocusHandle(int displayId, uint64_t entryId)
+{
+    return ((entryId + 1) << AF_FOCUS_HANDLE_DISPLAY_BITS) | (uint64_t) displayId;
+}
+
+bool FocusEngine::splitFocusHandle(uint64_t focusHandle, int& displayId, uint64_t& entryId)
+{
+    if ((focusHandle >> AF_FOCUS_HANDLE_DISPLAY_BITS) == 0)
+        return false;
+    displayId = (int) (focusHandle & ((1u << AF_FOCUS_HANDLE_DISPLAY_BITS) - 1));
+    entryId = (focusHandle >> AF_FOCUS_HANDLE_DISPLAY_BITS) - 1;
+    return true;
+}
+
+bool FocusEngine::pausedAppToActive(const int& displayId, int removedRequestTypeId,
+                                    AppNotificationList& notifications)
+{
+    DisplayFocusState& displayInfo = mDisplayInfo[displayId];
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "pausedAppToActive for removedRequest:%s", \
+        mFocusPolicy.getRequestTypeName(removedRequestTypeId).c_str());
+    if (displayInfo.getPausedAppList().size() == 1 && displayInfo.getActiveAppList().empty())
+    {
+        auto itPaused = displayInfo.pausedBegin();
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "pausedAppToActive: send AF_GRANETD to %s", \
+            mSymbolTable.getName(itPaused->appId).c_str());
+        notifications.push_back({itPaused->appId, "AF_GRANTED", 's', makeFocusHandle(displayId, itPaused->entryId)});
+        displayInfo.resumePausedApp(itPaused);
+    }
+    else
+    {
+        for (auto itPaused = displayInfo.pausedBegin(); itPaused != displayInfo.pausedEnd();)
+        {
+            FOCUS_ACTION_E policyAction = mFocusPolicy.getAction(itPaused->requestTypeId, removedRequestTypeId);
+            PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"pausedAppToActive policyAction:%s", FocusPolicy::actionToString(policyAction));
+            if (eFocusActionPause == policyAction && isIncomingPairRequestTypeActive(itPaused->requestTypeId, displayInfo))
+            {
+                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "pausedAppToActive: send AF_GRANETD to %s", \
+                    mSymbolTable.getName(itPaused->appId).c_str());
+                notifications.push_back({itPaused->appId, "AF_GRANTED", 's',
+                    makeFocusHandle(displayId, itPaused->entryId)});
+                itPaused = displayInfo.resumePausedApp(itPaused);
+            }
+            else
+            {
+                PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT,"pausedAppToActive incomingPairRequestType is not active");
+                ++itPaused;
+            }
+        }
+    }
+    return true;
+}
+
+//Check if any other active app incoming request list does not have pause for already paused app, do not resume in that case
+bool FocusEngine::isIncomingPairRequestTypeActive(int requestTypeId, const DisplayFocusState& displayInfo)
+{
+    PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "isIncomingPairRequestTypeActive for requestType:%s", \
+        mFocusPolicy.getRequestTypeName(requestTypeId).c_str());
+    for (auto itActive = displayInfo.getActiveAppList().begin(); itActive != displayInfo.getActiveAppList().end(); itActive++)
+    {
+        if (eFocusActionMix != mFocusPolicy.getAction(requestTypeId, itActive->requestTypeId))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,337 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "focusPolicy.h"
+#include "log.h"
+#include "defaultFocusPolicy.h"
+#include "staticFocusDecision.h"
+#include <cstring>
+
+//Upper bound of memoized outcomes, the cache is simply dropped when reached
+#define AF_MAX_FEASIBILITY_CACHE_SIZE 4096
+
+FocusPolicy::FocusPolicy()
+{
+    clear();
+}
+
+void FocusPolicy::clear()
+{
+    mRequestTypes.clear();
+    mRequestTypeIdMap.clear();
+    mFeasibilityCache.clear();
+    mIsDefault = false;
+    for (int active = 0; active < AF_MAX_REQUEST_TYPES; active++)
+        for (int incoming = 0; incoming < AF_MAX_REQUEST_TYPES; incoming++)
+            mActionTable[active][incoming] = eFocusActionNone;
+}
+
+/*
+ * Functionality of this method:
+ * ->First pass assigns an id to every request type declared in the config.
+ * ->Second pass resolves the "incoming" list of each request type into the action table.
+ *   As before, the first entry found for an incoming request type wins.
+ * ->An action other than mix, pause or lost rejects the whole config: the old lookup let such a
+ *   request mix, a policy would now deny it, so the mistake has to be fixed in the file.
+ */
+bool FocusPolicy::loadFromJson(const pbnjson::JValue& requestTypeArray)
+{
+    clear();
+    if (!requestTypeArray.isArray())
+    {
+        PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "FocusPolicy: request policyInfo is not an array");
+        return false;
+    }
+
+    std::vector<int> elementRequestTypeId;
+    for (const pbnjson::JValue& elements : requestTypeArray.items())
+    {
+        std::string requestType;
+        int requestTypeId = AF_INVALID_REQUEST_TYPE;
+        if (elements["request"].asString(requestType) != CONV_OK)
+        {
+            PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, \
+                "FocusPolicy: Invalid request type entry in config file, skipping");
+        }
+        else if (mRequestTypeIdMap.find(requestType) != mRequestTypeIdMap.end())
+        {
+            PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, \
+                "FocusPolicy: Duplicate request type %s in config file, last entry is used", requestType.c_str());
+            requestTypeId = mRequestTypeIdMap[requestType];
+            for (int incoming = 0; incoming < AF_MAX_REQUEST_TYPES; incoming++)
+                mActionTable[requestTypeId][incoming] = eFocusActionNone;
+            for (auto& id : elementRequestTypeId)
+                if (id == requestTypeId)
+                    id = AF_INVALID_REQUEST_TYPE;
+        }
+        else if (mRequestTypes.size() >= AF_MAX_REQUEST_TYPES)
+        {
+            PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, \
+                "FocusPolicy: More than %d request types in config file, skipping %s", \
+                AF_MAX_REQUEST_TYPES, requestType.c_str());
+        }
+        else
+        {
+            requestTypeId = (int) mRequestTypes.size();
+            REQUEST_TYPE_POLICY_INFO_T stPolicyInfo;
+            stPolicyInfo.requestType = requestType;
+            mRequestTypes.push_back(stPolicyInfo);
+            mRequestTypeIdMap[requestType] = requestTypeId;
+        }
+        if (requestTypeId != AF_INVALID_REQUEST_TYPE)
+            mRequestTypes[requestTypeId].priority = elements["priority"].asNumber<int>();
+        elementRequestTypeId.push_back(requestTypeId);
+    }
+
+    int index = 0;
+    for (const pbnjson::JValue& elements : requestTypeArray.items())
+    {
+        int requestTypeId = elementRequestTypeId[index++];
+        if (requestTypeId == AF_INVALID_REQUEST_TYPE)
+            continue;
+        pbnjson::JValue incomingRequestInfo = elements["incoming"];
+        if (!incomingRequestInfo.isArray())
+        {
+            PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "FocusPolicy: incoming list of %s is not an array", \
+                mRequestTypes[requestTypeId].requestType.c_str());
+            continue;
+        }
+        for (const pbnjson::JValue& incoming : incomingRequestInfo.items())
+        {
+            if (!incoming.isObject())
+                continue;
+            for (const auto& pair : incoming.children())
+            {
+                std::string incomingRequestType = pair.first.asString();
+                std::string actionName;
+                int incomingRequestTypeId = getRequestTypeId(incomingRequestType);
+                if (incomingRequestTypeId == AF_INVALID_REQUEST_TYPE)
+                {
+                    PM_LOG_WARNING(MSGID_CORE, INIT_KVCOUNT, "FocusPolicy: unknown incoming request type %s for %s", \
+                        incomingRequestType.c_str(), mRequestTypes[requestTypeId].requestType.c_str());
+                    continue;
+                }
+                FOCUS_ACTION_E action = eFocusActionNone;
+                if (pair.second.asString(actionName) == CONV_OK)
+                    action = actionFromString(actionName);
+                if (action == eFocusActionNone)
+                {
+                    PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "FocusPolicy: invalid action for %s incoming %s", \
+                        mRequestTypes[requestTypeId].requestType.c_str(), incomingRequestType.c_str());
+                    clear();
+                    return false;
+                }
+                if (mActionTable[requestTypeId][incomingRequestTypeId] == eFocusActionNone)
+                    mActionTable[requestTypeId][incomingRequestTypeId] = action;
+            }
+        }
+    }
+    return !mRequestTypes.empty();
+}
+
+/*
+ * Functionality of this method:
+ * ->The records already hold the request type ids and the resolved action table, they are
+ *   only checked and copied.
+ */
+bool FocusPolicy::loadFromImage(const POLICY_IMAGE_HEADER_T* image)
+{
+    clear();
+    const POLICY_IMAGE_REQUEST_TYPE_T *records = (const POLICY_IMAGE_REQUEST_TYPE_T *) (image + 1);
+    int requestTypeCount = (int) image->requestTypeCount;
+    for (int requestTypeId = 0; requestTypeId < requestTypeCount; requestTypeId++)
+    {
+        const POLICY_IMAGE_REQUEST_TYPE_T& record = records[requestTypeId];
+        size_t nameLength = strnlen(record.name, AF_POLICY_IMAGE_NAME_SIZE);
+        if (nameLength == 0 || nameLength == AF_POLICY_IMAGE_NAME_SIZE)
+        {
+            PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "FocusPolicy: Invalid request type name in policy image");
+            clear();
+            return false;
+        }
+        REQUEST_TYPE_POLICY_INFO_T stPolicyInfo;
+        stPolicyInfo.requestType.assign(record.name, nameLength);
+        stPolicyInfo.priority = record.priority;
+        if (!mRequestTypeIdMap.emplace(stPolicyInfo.requestType, requestTypeId).second)
+        {
+            PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "FocusPolicy: Duplicate request type %s in policy image", \
+                stPolicyInfo.requestType.c_str());
+            clear();
+            return false;
+        }
+        mRequestTypes.push_back(stPolicyInfo);
+        for (int incoming = 0; incoming < requestTypeCount; incoming++)
+        {
+            if (record.actions[incoming] > eFocusActionLost)
+            {
+                PM_LOG_ERROR(MSGID_CORE, INIT_KVCOUNT, "FocusPolicy: Invalid action for %s in policy image", \
+                    stPolicyInfo.requestType.c_str());
+                clear();
+                return false;
+            }
+            mActionTable[requestTypeId][incoming] = (FOCUS_ACTION_E) record.actions[incoming];
+        }
+    }
+    return !mRequestTypes.empty();
+}
+
+//The table is only copied for the lookups by name and the logs, decisions use the folded masks
+void FocusPolicy::loadDefault()
+{
+    clear();
+    for (int requestTypeId = 0; requestTypeId < DefaultFocusPolicy::requestTypeCount; requestTypeId++)
+    {
+        REQUEST_TYPE_POLICY_INFO_T stPolicyInfo;
+        stPolicyInfo.requestType = DefaultFocusPolicy::getRequestTypeName(requestTypeId);
+        stPolicyInfo.priority = DefaultFocusPolicy::getPriority(requestTypeId);
+        mRequestTypes.push_back(stPolicyInfo);
+        mRequestTypeIdMap[stPolicyInfo.requestType] = requestTypeId;
+        for (int incoming = 0; incoming < DefaultFocusPolicy::requestTypeCount; incoming++)
+            mActionTable[requestTypeId][incoming] = DefaultFocusPolicy::getAction(requestTypeId, incoming);
+    }
+    mIsDefault = true;
+}
+
+/*
+ * Functionality of this method:
+ * ->Returns the outcome of an incoming request for the given active and paused request types,
+ *   computing it on first use.
+ * ->The built-in policy needs neither, its outcome is a few mask operations.
+ */
+FEASIBILITY_OUTCOME_T FocusPolicy::getFeasibility(uint32_t activeRequestTypeMask, uint32_t pausedRequestTypeMask,
+                                                  int incomingRequestTypeId) const
+{
+    if (mIsDefault)
+        return StaticFocusDecision<DefaultFocusPolicy>::getFeasibility(activeRequestTypeMask, pausedRequestTypeMask,
+                                                                        incomingRequestTypeId);
+    uint64_t key = ((uint64_t) incomingRequestTypeId << 32) | ((uint64_t) pausedRequestTypeMask << AF_MAX_REQUEST_TYPES) |
+                   activeRequestTypeMask;
+    auto it = mFeasibilityCache.find(key);
+    if (it != mFeasibilityCache.end())
+        return it->second;
+    if (mFeasibilityCache.size() >= AF_MAX_FEASIBILITY_CACHE_SIZE)
+        mFeasibilityCache.clear();
+    return mFeasibilityCache.emplace(key, computeFeasibility(activeRequestTypeMask, pausedRequestTypeMask,
+                                                             incomingRequestTypeId)).first->second;
+}
+
+/*
+ * Functionality of this method:
+ * ->The request is granted only if every active request type has an entry for the incoming one.
+ * ->Active request types are paused or lost as per their entry, paused ones can only be lost.
+ */
+FEASIBILITY_OUTCOME_T FocusPolicy::computeFeasibility(uint32_t activeRequestTypeMask, uint32_t pausedRequestTypeMask,
+                                                      int incomingRequestTypeId) const
+{
+    FEASIBILITY_OUTCOME_T outcome;
+    for (int requestTypeId = 0; requestTypeId < getRequestTypeCount(); requestTypeId++)
+    {
+        uint32_t bit = REQUEST_TYPE_BIT(requestTypeId);
+        FOCUS_ACTION_E action = mActionTable[requestTypeId][incomingRequestTypeId];
+        if (activeRequestTypeMask & bit)
+        {
+            if (eFocusActionNone == action)
+            {
+                outcome.granted = false;
+                outcome.pauseMask = outcome.lostActiveMask = outcome.lostPausedMask = 0;
+                return outcome;
+            }
+            if (eFocusActionPause == action)
+                outcome.pauseMask |= bit;
+            else if (eFocusActionLost == action)
+                outcome.lostActiveMask |= bit;
+        }
+        if ((pausedRequestTypeMask & bit) && eFocusActionLost == action)
+            outcome.lostPausedMask |= bit;
+    }
+    return outcome;
+}
+
+void FocusPolicy::print() const
+{
+    for (int active = 0; active < getRequestTypeCount(); active++)
+    {
+        std::string incomingInfo;
+        for (int incoming = 0; incoming < getRequestTypeCount(); incoming++)
+        {
+            if (mActionTable[active][incoming] == eFocusActionNone)
+                continue;
+            if (!incomingInfo.empty())
+                incomingInfo += ' ';
+            incomingInfo += mRequestTypes[incoming].requestType;
+            incomingInfo += ':';
+            incomingInfo += actionToString(mActionTable[active][incoming]);
+        }
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "RequestType: %s  Priority: %d incomingRequestInfo: %s", \
+            mRequestTypes[active].requestType.c_str(), mRequestTypes[active].priority, incomingInfo.c_str());
+    }
+}
+
+int FocusPolicy::getRequestTypeId(const std::string& requestType) const
+{
+    auto it = mRequestTypeIdMap.find(requestType);
+    if (it == mRequestTypeIdMap.end())
+        return AF_INVALID_REQUEST_TYPE;
+    return it->second;
+}
+
+//There are only a few request types, a linear compare avoids building a std::string from the payload
+int FocusPolicy::getRequestTypeId(const char* requestType, size_t length) const
+{
+    for (int requestTypeId = 0; requestTypeId < getRequestTypeCount(); requestTypeId++)
+    {
+        const std::string& name = mRequestTypes[requestTypeId].requestType;
+        if (name.length() == length && name.compare(0, length, requestType, length) == 0)
+            return requestTypeId;
+    }
+    return AF_INVALID_REQUEST_TYPE;
+}
+
+const std::string& FocusPolicy::getRequestTypeName(int requestTypeId) const
+{
+    static const std::string unknown;
+    if (requestTypeId < 0 || requestTypeId >= getRequestTypeCount())
+        return unknown;
+    return mRequestTypes[requestTypeId].requestType;
+}
+
+const char* FocusPolicy::actionToString(FOCUS_ACTION_E action)
+{
+    switch (action)
+    {
+        case eFocusActionMix:
+            return "mix";
+        case eFocusActionPause:
+            return "pause";
+        case eFocusActionLost:
+            return "lost";
+        default:
+            return "none";
+    }
+}
+
+FOCUS_ACTION_E FocusPolicy::actionFromString(const std::string& action)
+{
+    if ("mix" == action)
+        return eFocusActionMix;
+    if ("pause" == action)
+        return eFocusActionPause;
+    if ("lost" == action)
+        return eFocusActionLost;
+    return eFocusActionNone;
+}
@@ -17,15 +17,486 @@
 * LICENSE@@@ */
 
 #include "log.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <system_error>
+#include <cstddef>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <cstdint>
+
+//Ring size must be a power of two
+#define AF_ASYNC_LOG_RING_SIZE      512
+#define AF_ASYNC_LOG_TEXT_SIZE      512
+#define AF_ASYNC_LOG_MAX_ARGS       12
+#define AF_ASYNC_LOG_SPEC_SIZE      32
 
 PmLogContext audioFocusMgrLogContext;
+std::atomic<int> audioFocusMgrLogLevel(kPmLogLevel_Info);
+
+/*
+ * Bounded queue with one sequence number per slot: producers claim a slot with a CAS on the
+ * enqueue position and publish it by advancing its sequence, so no lock is taken on the
+ * logging side. Copying the arguments and the wakeup of the writer are not async-signal-safe,
+ * signals are handled on the main loop rather than logged from a handler.
+ * A record keeps the format, which has to be a string literal, and its arguments, strings are
+ * copied into the record. The background thread, the only consumer, formats it.
+ */
+typedef enum AsyncLogArgType
+{
+    ASYNC_LOG_ARG_INT,
+    ASYNC_LOG_ARG_LONG,
+    ASYNC_LOG_ARG_LONG_LONG,
+    ASYNC_LOG_ARG_SIZE,
+    ASYNC_LOG_ARG_PTRDIFF,
+    ASYNC_LOG_ARG_INTMAX,
+    ASYNC_LOG_ARG_DOUBLE,
+    ASYNC_LOG_ARG_STRING,
+    ASYNC_LOG_ARG_POINTER,
+    ASYNC_LOG_ARG_UNSUPPORTED
+}ASYNC_LOG_ARG_TYPE_E;
+
+//One conversion of a format, widthStar and precisionStar take an int argument before the value
+typedef struct AsyncLogConversion
+{
+    const char *begin;
+    const char *end;
+    bool widthStar;
+    bool precisionStar;
+    int precision;                      //-1 when not given as digits
+    ASYNC_LOG_ARG_TYPE_E type;
+}ASYNC_LOG_CONVERSION_T;
+
+typedef union AsyncLogArg
+{
+    long long integer;                  //every integer type, and the text offset of a string
+    double real;
+    const void *pointer;
+}ASYNC_LOG_ARG_T;
+
+typedef struct AsyncLogRecord
+{
+    std::atomic<size_t> sequence;
+    int level;
+    const char *msgid;
+    const char *format;                 //nullptr when text already holds the formatted message
+    int argCount;
+    ASYNC_LOG_ARG_T args[AF_ASYNC_LOG_MAX_ARGS];
+    char text[AF_ASYNC_LOG_TEXT_SIZE];  //copied strings, the last byte stays an empty string
+}ASYNC_LOG_RECORD_T;
+
+static ASYNC_LOG_RECORD_T asyncLogRing[AF_ASYNC_LOG_RING_SIZE];
+static std::atomic<size_t> asyncLogEnqueuePos(0);
+static size_t asyncLogDequeuePos = 0;
+static std::atomic<unsigned long> asyncLogDropCount(0);
+static std::atomic<bool> asyncLogRunning(false);
+static std::atomic<bool> asyncLogWriterSleeping(false);
+static bool asyncLogStopRequested = false;       //under asyncLogMutex
+static std::mutex asyncLogMutex;
+static std::condition_variable asyncLogCondition;
+static std::thread asyncLogThread;
+
+/*
+ * Functionality of this method:
+ * ->Reads the conversion starting at the '%' of cursor, up to and including its conversion
+ *   character. A "%%" has no argument and is returned as unsupported with cursor on its end.
+ * ->Conversions the record cannot carry, like %n or long double, are unsupported and the
+ *   caller then formats the whole message itself.
+ */
+static bool parseAsyncLogConversion(const char *cursor, ASYNC_LOG_CONVERSION_T &conversion)
+{
+    conversion.begin = cursor++;
+    conversion.widthStar = false;
+    conversion.precisionStar = false;
+    conversion.precision = -1;
+    conversion.type = ASYNC_LOG_ARG_UNSUPPORTED;
+    while (*cursor && strchr("-+ #0'", *cursor))
+        cursor++;
+    if (*cursor == '*')
+    {
+        conversion.widthStar = true;
+        cursor++;
+    }
+    while (*cursor >= '0' && *cursor <= '9')
+        cursor++;
+    if (*cursor == '.')
+    {
+        cursor++;
+        if (*cursor == '*')
+        {
+            conversion.precisionStar = true;
+            cursor++;
+        }
+        else
+        {
+            conversion.precision = 0;
+            while (*cursor >= '0' && *cursor <= '9')
+                conversion.precision = conversion.precision * 10 + (*cursor++ - '0');
+        }
+    }
+    char length = 0;
+    if (*cursor == 'h')
+        length = (*++cursor == 'h') ? (cursor++, 'H') : 'h';
+    else if (*cursor == 'l')
+        length = (*++cursor == 'l') ? (cursor++, 'q') : 'l';
+    else if (*cursor && strchr("qjztL", *cursor))
+        length = *cursor++;
+    if (*cursor == '\0')
+        return false;
+    conversion.end = cursor + 1;
+    switch (*cursor)
+    {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            if (length == 'l')
+                conversion.type = ASYNC_LOG_ARG_LONG;
+            else if (length == 'q')
+                conversion.type = ASYNC_LOG_ARG_LONG_LONG;
+            else if (length == 'z')
+                conversion.type = ASYNC_LOG_ARG_SIZE;
+            else if (length == 't')
+                conversion.type = ASYNC_LOG_ARG_PTRDIFF;
+            else if (length == 'j')
+                conversion.type = ASYNC_LOG_ARG_INTMAX;
+            else if (length != 'L')
+                conversion.type = ASYNC_LOG_ARG_INT;
+            break;
+        case 'c':
+            if (!length)
+                conversion.type = ASYNC_LOG_ARG_INT;
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            if (length != 'L')
+                conversion.type = ASYNC_LOG_ARG_DOUBLE;
+            break;
+        case 's':
+            if (!length)
+                conversion.type = ASYNC_LOG_ARG_STRING;
+            break;
+        case 'p':
+            conversion.type = ASYNC_LOG_ARG_POINTER;
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+//Copies string into the text of record, truncated to what is left, and returns its offset
+static long long copyAsyncLogString(ASYNC_LOG_RECORD_T *record, size_t &textLength, const char *string, int precision)
+{
+    if (!string)
+        string = "(null)";
+    size_t length = strnlen(string, precision >= 0 ? (size_t) precision : AF_ASYNC_LOG_TEXT_SIZE);
+    if (textLength + 1 >= AF_ASYNC_LOG_TEXT_SIZE)
+        return AF_ASYNC_LOG_TEXT_SIZE - 1;
+    if (length > AF_ASYNC_LOG_TEXT_SIZE - 2 - textLength)
+        length = AF_ASYNC_LOG_TEXT_SIZE - 2 - textLength;
+    long long offset = (long long) textLength;
+    memcpy(record->text + textLength, string, length);
+    record->text[textLength + length] = '\0';
+    textLength += length + 1;
+    return offset;
+}
+
+//Fills the arguments of record from args, false if the format needs more than a record holds
+static bool captureAsyncLogArgs(ASYNC_LOG_RECORD_T *record, const char *format, va_list args)
+{
+    size_t textLength = 0;
+    record->argCount = 0;
+    record->text[AF_ASYNC_LOG_TEXT_SIZE - 1] = '\0';
+    for (const char *cursor = strchr(format, '%'); cursor; cursor = strchr(cursor, '%'))
+    {
+        if (cursor[1] == '%')
+        {
+            cursor += 2;
+            continue;
+        }
+        ASYNC_LOG_CONVERSION_T conversion;
+        if (!parseAsyncLogConversion(cursor, conversion) || conversion.type == ASYNC_LOG_ARG_UNSUPPORTED || \
+            record->argCount + conversion.widthStar + conversion.precisionStar + 1 > AF_ASYNC_LOG_MAX_ARGS)
+            return false;
+        if (conversion.widthStar)
+            record->args[record->argCount++].integer = va_arg(args, int);
+        if (conversion.precisionStar)
+        {
+            conversion.precision = va_arg(args, int);
+            record->args[record->argCount++].integer = conversion.precision;
+        }
+        ASYNC_LOG_ARG_T &arg = record->args[record->argCount++];
+        switch (conversion.type)
+        {
+            case ASYNC_LOG_ARG_INT:         arg.integer = va_arg(args, int); break;
+            case ASYNC_LOG_ARG_LONG:        arg.integer = va_arg(args, long); break;
+            case ASYNC_LOG_ARG_LONG_LONG:   arg.integer = va_arg(args, long long); break;
+            case ASYNC_LOG_ARG_SIZE:        arg.integer = (long long) va_arg(args, size_t); break;
+            case ASYNC_LOG_ARG_PTRDIFF:     arg.integer = va_arg(args, ptrdiff_t); break;
+            case ASYNC_LOG_ARG_INTMAX:      arg.integer = (long long) va_arg(args, intmax_t); break;
+            case ASYNC_LOG_ARG_DOUBLE:      arg.real = va_arg(args, double); break;
+            case ASYNC_LOG_ARG_POINTER:     arg.pointer = va_arg(args, void *); break;
+            case ASYNC_LOG_ARG_STRING:
+                arg.integer = copyAsyncLogString(record, textLength, va_arg(args, const char *), conversion.precision);
+                break;
+            default:
+                return false;
+        }
+        cursor = conversion.end;
+    }
+    return true;
+}
+
+/*
+ * Functionality of this method:
+ * ->Formats a record on the writer thread, one conversion at a time: a '*' is replaced by the
+ *   argument it took, so snprintf only gets the value of the conversion.
+ */
+static void formatAsyncLogRecord(const ASYNC_LOG_RECORD_T &record, char *output, size_t size)
+{
+    size_t length = 0;
+    int argIndex = 0;
+    const char *cursor = record.format;
+    while (*cursor && length + 1 < size)
+    {
+        if (*cursor != '%' || cursor[1] == '%')
+        {
+            output[length++] = *cursor;
+            cursor += (*cursor == '%') ? 2 : 1;
+            continue;
+        }
+        ASYNC_LOG_CONVERSION_T conversion;
+        parseAsyncLogConversion(cursor, conversion);
+        char spec[AF_ASYNC_LOG_SPEC_SIZE];
+        size_t specLength = 0;
+        for (const char *specCursor = conversion.begin; specCursor < conversion.end && \
+             specLength + 12 < sizeof(spec); specCursor++)
+        {
+            if (*specCursor != '*')
+            {
+                spec[specLength++] = *specCursor;
+                continue;
+            }
+            long long starValue = record.args[argIndex++].integer;
+            //A negative precision is as if it was not given
+            if (specCursor[-1] == '.' && starValue < 0)
+                specLength--;
+            else
+                specLength += snprintf(spec + specLength, sizeof(spec) - specLength, "%lld", starValue);
+        }
+        spec[specLength] = '\0';
+        const ASYNC_LOG_ARG_T &arg = record.args[argIndex++];
+        char *target = output + length;
+        size_t left = size - length;
+        int written = 0;
+        switch (conversion.type)
+        {
+            case ASYNC_LOG_ARG_INT:         written = snprintf(target, left, spec, (int) arg.integer); break;
+            case ASYNC_LOG_ARG_LONG:        written = snprintf(target, left, spec, (long) arg.integer); break;
+            case ASYNC_LOG_ARG_LONG_LONG:   written = snprintf(target, left, spec, arg.integer); break;
+            case ASYNC_LOG_ARG_SIZE:        written = snprintf(target, left, spec, (size_t) arg.integer); break;
+            case ASYNC_LOG_ARG_PTRDIFF:     written = snprintf(target, left, spec, (ptrdiff_t) arg.integer); break;
+            case ASYNC_LOG_ARG_INTMAX:      written = snprintf(target, left, spec, (intmax_t) arg.integer); break;
+            case ASYNC_LOG_ARG_DOUBLE:      written = snprintf(target, left, spec, arg.real); break;
+            case ASYNC_LOG_ARG_POINTER:     written = snprintf(target, left, spec, arg.pointer); break;
+            case ASYNC_LOG_ARG_STRING:
+                written = snprintf(target, left, spec, record.text + arg.integer);
+                break;
+            default:
+                break;
+        }
+        if (written > 0)
+            length += ((size_t) written < left) ? (size_t) written : left - 1;
+        cursor = conversion.end;
+    }
+    output[length] = '\0';
+}
+
+static void emitLogRecord(const ASYNC_LOG_RECORD_T &record)
+{
+    char formatted[AF_ASYNC_LOG_TEXT_SIZE];
+    const char *text = record.text;
+    if (record.format)
+    {
+        formatAsyncLogRecord(record, formatted, sizeof(formatted));
+        text = formatted;
+    }
+    switch (record.level)
+    {
+        case kPmLogLevel_Error:
+            PmLogError(getPmLogContext(), record.msgid, INIT_KVCOUNT, "%s", text);
+            break;
+        case kPmLogLevel_Warning:
+            PmLogWarning(getPmLogContext(), record.msgid, INIT_KVCOUNT, "%s", text);
+            break;
+        case kPmLogLevel_Info:
+            PmLogInfo(getPmLogContext(), record.msgid, INIT_KVCOUNT, "%s", text);
+            break;
+        default:
+            PmLogDebug(getPmLogContext(), "%s", text);
+            break;
+    }
+}
+
+static bool isAsyncLogRecordPublished()
+{
+    const ASYNC_LOG_RECORD_T &record = asyncLogRing[asyncLogDequeuePos & (AF_ASYNC_LOG_RING_SIZE - 1)];
+    return record.sequence.load(std::memory_order_acquire) == asyncLogDequeuePos + 1;
+}
+
+//Emits every published record
+static void drainAsyncLog()
+{
+    bool drained = false;
+    while (isAsyncLogRecordPublished())
+    {
+        ASYNC_LOG_RECORD_T &record = asyncLogRing[asyncLogDequeuePos & (AF_ASYNC_LOG_RING_SIZE - 1)];
+        emitLogRecord(record);
+        record.sequence.store(asyncLogDequeuePos + AF_ASYNC_LOG_RING_SIZE, std::memory_order_release);
+        asyncLogDequeuePos++;
+        drained = true;
+    }
+    unsigned long dropped = asyncLogDropCount.exchange(0);
+    if (dropped)
+        PmLogWarning(getPmLogContext(), MSGID_CORE, INIT_KVCOUNT, "asyncLog: ring full, %lu messages dropped", dropped);
+    //PmLog has just checked the level of these messages anyway, a lowered level applies from here
+    if (drained)
+        refreshPmLogLevel();
+}
+
+/*
+ * Functionality of this method:
+ * ->Sleeps until a producer finds the writer sleeping after publishing a record. The flag is
+ *   set before the ring is checked again, and producers check it after publishing, so one of
+ *   the two always sees the other and no wakeup is lost. The idle thread never wakes up.
+ */
+static void asyncLogThreadMain()
+{
+    std::unique_lock<std::mutex> lock(asyncLogMutex);
+    while (!asyncLogStopRequested)
+    {
+        lock.unlock();
+        drainAsyncLog();
+        lock.lock();
+        asyncLogWriterSleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (isAsyncLogRecordPublished())
+        {
+            asyncLogWriterSleeping.store(false);
+            continue;
+        }
+        asyncLogCondition.wait(lock, [] { return !asyncLogWriterSleeping.load() || asyncLogStopRequested; });
+        asyncLogWriterSleeping.store(false);
+    }
+    lock.unlock();
+    drainAsyncLog();
+}
+
+bool startAsyncLog()
+{
+    if (asyncLogRunning.load())
+        return true;
+    for (size_t index = 0; index < AF_ASYNC_LOG_RING_SIZE; index++)
+        asyncLogRing[index].sequence.store(asyncLogEnqueuePos.load() + index, std::memory_order_relaxed);
+    asyncLogDequeuePos = asyncLogEnqueuePos.load();
+    asyncLogStopRequested = false;
+    asyncLogWriterSleeping = false;
+    try
+    {
+        asyncLogThread = std::thread(asyncLogThreadMain);
+    }
+    catch (const std::system_error&)
+    {
+        PmLogError(getPmLogContext(), MSGID_INIT, INIT_KVCOUNT, "asyncLog: failed to start thread, logging synchronously");
+        return false;
+    }
+    asyncLogRunning = true;
+    return true;
+}
+
+//Flushes the pending records, later messages go to PmLog directly
+void stopAsyncLog()
+{
+    if (!asyncLogRunning.load())
+        return;
+    asyncLogRunning = false;
+    {
+        std::lock_guard<std::mutex> lock(asyncLogMutex);
+        asyncLogStopRequested = true;
+    }
+    asyncLogCondition.notify_one();
+    asyncLogThread.join();
+}
+
+bool isAsyncLogRunning()
+{
+    return asyncLogRunning.load(std::memory_order_relaxed);
+}
+
+void asyncLogWrite(int level, const char *msgid, const char *format, ...)
+{
+    size_t position = asyncLogEnqueuePos.load(std::memory_order_relaxed);
+    ASYNC_LOG_RECORD_T *record = nullptr;
+    while (true)
+    {
+        record = &asyncLogRing[position & (AF_ASYNC_LOG_RING_SIZE - 1)];
+        intptr_t diff = (intptr_t) record->sequence.load(std::memory_order_acquire) - (intptr_t) position;
+        if (diff == 0)
+        {
+            if (asyncLogEnqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            asyncLogDropCount++;
+            return;
+        }
+        else
+            position = asyncLogEnqueuePos.load(std::memory_order_relaxed);
+    }
+    record->level = level;
+    record->msgid = msgid;
+    record->format = format;
+    va_list args;
+    va_start(args, format);
+    bool captured = captureAsyncLogArgs(record, format, args);
+    va_end(args);
+    //A format the record cannot carry is formatted here, which is rare enough to be acceptable
+    if (!captured)
+    {
+        record->format = nullptr;
+        va_start(args, format);
+        vsnprintf(record->text, sizeof(record->text), format, args);
+        va_end(args);
+    }
+    record->sequence.store(position + 1, std::memory_order_release);
+
+    //Only a sleeping writer is woken up, that is once the ring was empty
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (asyncLogWriterSleeping.load())
+    {
+        {
+            std::lock_guard<std::mutex> lock(asyncLogMutex);
+            asyncLogWriterSleeping.store(false);
+        }
+        asyncLogCondition.notify_one();
+    }
+}
 
 PmLogErr setPmLogContext(const char* logContextName)
 {
     PmLogErr error = PmLogGetContext(logContextName, &audioFocusMgrLogContext);
+    refreshPmLogLevel();
     return error;
 }
 
+void refreshPmLogLevel()
+{
+    int contextLevel = kPmLogLevel_Info;
+    if (PmLogGetContextLevel(audioFocusMgrLogContext, &contextLevel) == kPmLogErr_None)
+        audioFocusMgrLogLevel.store(contextLevel, std::memory_order_relaxed);
+}
+
 
 PmLogContext getPmLogContext()
 {
@@ -14,6 +14,7 @@
 #include <iostream>
 #include <luna-service2/lunaservice.h>
 #include <glib.h>
+#include <glib-unix.h>
 #include <audioFocusManager.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -67,8 +68,17 @@ bool audioServiceRegister(std::string srvcname, GMainLoop *mainLoop, LSHandle **
 
 AudioFocusManager *audioFocusManager = NULL;
 
-void signalHandler(int signal)
+//Runs on the main loop through g_unix_signal_add, so it can log and quit the loop
+static gboolean signalHandler(gpointer data)
 {
+    int signal = GPOINTER_TO_INT(data);
+    //Sent after a PmLog level change, a more verbose level is not seen otherwise
+    if (signal == SIGHUP)
+    {
+        refreshPmLogLevel();
+        PM_LOG_INFO(MSGID_CORE, INIT_KVCOUNT, "signal received.. signal[SIGHUP], log level reloaded");
+        return G_SOURCE_CONTINUE;
+    }
     PM_LOG_WARNING(MSGID_INIT, INIT_KVCOUNT, "Signal Caught");
 
     const char *str = nullptr;
@@ -94,7 +104,7 @@ void signalHandler(int signal)
         g_main_loop_quit(mainLoop);
         PM_LOG_INFO(MSGID_STUTDOWN, INIT_KVCOUNT,"signalHandler-> g_main_loop_quit(mainLoop)");
     }
-    return;
+    return G_SOURCE_CONTINUE;
 }
 
 void exit_proc(void)
@@ -107,6 +117,7 @@ void exit_proc(void)
     }
     else
         PM_LOG_INFO(MSGID_STUTDOWN, INIT_KVCOUNT, "AudioFocusManager object is null");
+    stopAsyncLog();
 }
 
 int main(int argc, char *argv[])
@@ -119,17 +130,21 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
     PM_LOG_INFO(MSGID_INIT, INIT_KVCOUNT, "Registered for PmLog");
-    if (SIG_ERR == signal(SIGTERM, signalHandler))
+    startAsyncLog();
+    if (!g_unix_signal_add(SIGTERM, signalHandler, GINT_TO_POINTER(SIGTERM)))
     {
         PM_LOG_ERROR(MSGID_INIT, INIT_KVCOUNT, "Failed to set SIGTERM handler!");
         return -1;
     }
 
-    if (SIG_ERR == signal(SIGINT, signalHandler))
+    if (!g_unix_signal_add(SIGINT, signalHandler, GINT_TO_POINTER(SIGINT)))
     {
         PM_LOG_ERROR(MSGID_INIT, INIT_KVCOUNT, "Failed to set SIGINT handler!");
         return -1;
     }
+
+    if (!g_unix_signal_add(SIGHUP, signalHandler, GINT_TO_POINTER(SIGHUP)))
+        PM_LOG_WARNING(MSGID_INIT, INIT_KVCOUNT, "Failed to set SIGHUP handler, a raised log level applies after a restart");
     mainLoop = g_main_loop_new(NULL, FALSE);
 
     if(NULL == mainLoop)
@@ -20,9 +20,37 @@
 #include "messageUtils.h"
 #include "ConstString.h"
 #include "log.h"
+#include <unordered_map>
+#include <tuple>
+
+/*
+ * Schemas are looked up by address first: they are string literals, so the text
+ * only needs a strcmp to confirm the hit and no std::string is built per message.
+ * A new address falls back to the lookup by text, which compiles unknown schemas.
+ */
+const pbnjson::JSchema & getCachedSchema(const char * schema)
+{
+    typedef std::pair<const std::string *, const pbnjson::JSchema *> CachedSchemaRef;
+    static std::unordered_map<std::string, pbnjson::JSchemaFragment> schemaByText;
+    static std::unordered_map<const char *, CachedSchemaRef> schemaByAddress;
+
+    auto itAddress = schemaByAddress.find(schema);
+    if (itAddress != schemaByAddress.end() && strcmp(itAddress->second.first->c_str(), schema) == 0)
+        return *itAddress->second.second;
+
+    auto itText = schemaByText.find(schema);
+    if (itText == schemaByText.end())
+    {
+        PM_LOG_INFO(MSGID_PARSE_JSON, INIT_KVCOUNT, "Compiling schema '%s'", schema);
+        itText = schemaByText.emplace(std::piecewise_construct, std::forward_as_tuple(schema),
+                                      std::forward_as_tuple(schema)).first;
+    }
+    schemaByAddress[schema] = CachedSchemaRef(&itText->first, &itText->second);
+    return itText->second;
+}
 
 JsonMessageParser::JsonMessageParser(const char * json, const char * schema) :
-                             mJson(json), mSchema(schema)
+                             mJson(json), mSchema(getCachedSchema(schema))
 {
 }
 
@@ -32,8 +60,7 @@ bool JsonMessageParser::parse(const char * callerFunction)
     if (!mParser.parse(mJson, mSchema))
     {
         const char * errorText = "Could not validate json message against schema";
-        pbnjson::JSchemaFragment    genericSchema(SCHEMA_ANY);
-        if (!mParser.parse(mJson, genericSchema))
+        if (!mParser.parse(mJson, getCachedSchema(SCHEMA_ANY)))
             errorText = "Invalid json message";
         PM_LOG_ERROR(MSGID_PARSE_JSON, INIT_KVCOUNT, "%s: %s '%s'", callerFunction, errorText, mJson);
         return false;
@@ -46,7 +73,7 @@ LSMessageJsonParser::LSMessageJsonParser(LSMessage * message,
                                          const char * schema) :
                                          mMessage(message),
                                          mSchemaText(schema),
-                                         mSchema(schema)
+                                         mSchema(getCachedSchema(schema))
 {
 }
 
@@ -90,8 +117,7 @@ bool LSMessageJsonParser::parse(const char * callerFunction,
         bool notJson = true;
         if (strcmp(mSchemaText, SCHEMA_ANY) != 0)
         {
-            pbnjson::JSchemaFragment    genericSchema(SCHEMA_ANY);
-            notJson = !mParser.parse(payload, genericSchema);
+            notJson = !mParser.parse(payload, getCachedSchema(SCHEMA_ANY));
         }
         if (notJson)
         {
@@ -119,6 +145,208 @@ bool LSMessageJsonParser::parse(const char * callerFunction,
     return true;
 }
 
+static inline const char * skipJsonWhitespace(const char * cursor)
+{
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')
+        cursor++;
+    return cursor;
+}
+
+// Plain ASCII string without escape sequences, cursor is on the opening quote
+static const char * parseJsonPlainString(const char * cursor, JSON_STRING_VIEW_T & value)
+{
+    const char * start = ++cursor;
+    while (*cursor != '"')
+    {
+        unsigned char c = (unsigned char) *cursor;
+        if (c < 0x20 || c >= 0x80 || c == '\\')
+            return nullptr;
+        cursor++;
+    }
+    value.data = start;
+    value.length = cursor - start;
+    return cursor + 1;
+}
+
+// Integer without fraction, exponent or leading zero, small enough to never overflow
+static const char * parseJsonSmallInteger(const char * cursor, int & value)
+{
+    bool negative = (*cursor == '-');
+    if (negative)
+        cursor++;
+    if (*cursor < '0' || *cursor > '9' || (*cursor == '0' && cursor[1] >= '0' && cursor[1] <= '9'))
+        return nullptr;
+    int result = 0;
+    int digits = 0;
+    while (*cursor >= '0' && *cursor <= '9')
+    {
+        if (++digits > 9)
+            return nullptr;
+        result = result * 10 + (*cursor++ - '0');
+    }
+    if (*cursor == '.' || *cursor == 'e' || *cursor == 'E')
+        return nullptr;
+    value = negative ? -result : result;
+    return cursor;
+}
+
+// Non negative integer, at most 15 digits so that it stays exact in a json double
+static const char * parseJsonUnsignedInteger(const char * cursor, uint64_t & value)
+{
+    if (*cursor < '0' || *cursor > '9' || (*cursor == '0' && cursor[1] >= '0' && cursor[1] <= '9'))
+        return nullptr;
+    uint64_t result = 0;
+    int digits = 0;
+    while (*cursor >= '0' && *cursor <= '9')
+    {
+        if (++digits > 15)
+            return nullptr;
+        result = result * 10 + (*cursor++ - '0');
+    }
+    if (*cursor == '.' || *cursor == 'e' || *cursor == 'E')
+        return nullptr;
+    value = result;
+    return cursor;
+}
+
+static const char * parseJsonBoolean(const char * cursor, bool & value)
+{
+    if (strncmp(cursor, "true", 4) == 0)
+    {
+        value = true;
+        return cursor + 4;
+    }
+    if (strncmp(cursor, "false", 5) == 0)
+    {
+        value = false;
+        return cursor + 5;
+    }
+    return nullptr;
+}
+
+static unsigned int focusRequestParam(const JSON_STRING_VIEW_T & key)
+{
+    if (key.length == 11 && strncmp(key.data, "requestType", 11) == 0)
+        return FOCUS_PARAM_REQUEST_TYPE;
+    if (key.length == 9 && strncmp(key.data, "displayId", 9) == 0)
+        return FOCUS_PARAM_DISPLAY_ID;
+    if (key.length == 9 && strncmp(key.data, "subscribe", 9) == 0)
+        return FOCUS_PARAM_SUBSCRIBE;
+    if (key.length == 10 && strncmp(key.data, "streamType", 10) == 0)
+        return FOCUS_PARAM_STREAM_TYPE;
+    if (key.length == 11 && strncmp(key.data, "focusHandle", 11) == 0)
+        return FOCUS_PARAM_FOCUS_HANDLE;
+    return 0;
+}
+
+bool parseFocusRequestPayload(const char * payload, unsigned int allowedParams, unsigned int requiredParams,
+                              FOCUS_REQUEST_PARAMS_T & params)
+{
+    if (payload == nullptr)
+        return false;
+    params.presentParams = 0;
+    const char * cursor = skipJsonWhitespace(payload);
+    if (*cursor++ != '{')
+        return false;
+    cursor = skipJsonWhitespace(cursor);
+    if (*cursor == '}')
+        cursor++;
+    else
+    {
+        while (true)
+        {
+            JSON_STRING_VIEW_T key;
+            if (*cursor != '"' || (cursor = parseJsonPlainString(cursor, key)) == nullptr)
+                return false;
+            unsigned int param = focusRequestParam(key);
+            if (param == 0 || !(param & allowedParams) || (param & params.presentParams))
+                return false;
+            cursor = skipJsonWhitespace(cursor);
+            if (*cursor++ != ':')
+                return false;
+            cursor = skipJsonWhitespace(cursor);
+            switch (param)
+            {
+                case FOCUS_PARAM_REQUEST_TYPE:
+                    cursor = (*cursor == '"') ? parseJsonPlainString(cursor, params.requestType) : nullptr;
+                    break;
+                case FOCUS_PARAM_STREAM_TYPE:
+                    cursor = (*cursor == '"') ? parseJsonPlainString(cursor, params.streamType) : nullptr;
+                    break;
+                case FOCUS_PARAM_DISPLAY_ID:
+                    cursor = parseJsonSmallInteger(cursor, params.displayId);
+                    break;
+                case FOCUS_PARAM_SUBSCRIBE:
+                    cursor = parseJsonBoolean(cursor, params.subscribe);
+                    break;
+                case FOCUS_PARAM_FOCUS_HANDLE:
+                    cursor = parseJsonUnsignedInteger(cursor, params.focusHandle);
+                    break;
+            }
+            if (cursor == nullptr)
+                return false;
+            params.presentParams |= param;
+            cursor = skipJsonWhitespace(cursor);
+            if (*cursor == '}')
+            {
+                cursor++;
+                break;
+            }
+            if (*cursor++ != ',')
+                return false;
+            cursor = skipJsonWhitespace(cursor);
+        }
+    }
+    if (*skipJsonWhitespace(cursor) != '\0')
+        return false;
+    return (params.presentParams & requiredParams) == requiredParams;
+}
+
+bool parseFocusRequestMessage(LSHandle * sender, LSMessage * message, const char * schema, unsigned int allowedParams,
+                              unsigned int requiredParams, const char * callerFunction, FOCUS_REQUEST_PARAMS_T & params)
+{
+    const char * payload = LSMessageGetPayload(message);
+    if (parseFocusRequestPayload(payload, allowedParams, requiredParams, params))
+    {
+        PM_LOG_INFO(MSGID_PARSE_JSON, INIT_KVCOUNT,"Received: %s '%s'", callerFunction, payload);
+        return true;
+    }
+
+    LSMessageJsonParser msg(message, schema);
+    if (!msg.parse(callerFunction, sender))
+        return false;
+    readFocusRequestParams(msg.get(), allowedParams, params);
+    return true;
+}
+
+void readFocusRequestParams(const pbnjson::JValue & payload, unsigned int allowedParams, FOCUS_REQUEST_PARAMS_T & params)
+{
+    params.presentParams = 0;
+    if ((allowedParams & FOCUS_PARAM_REQUEST_TYPE) && payload["requestType"].asString(params.requestTypeStorage) == CONV_OK)
+    {
+        params.requestType.data = params.requestTypeStorage.c_str();
+        params.requestType.length = params.requestTypeStorage.length();
+        params.presentParams |= FOCUS_PARAM_REQUEST_TYPE;
+    }
+    if ((allowedParams & FOCUS_PARAM_STREAM_TYPE) && payload["streamType"].asString(params.streamTypeStorage) == CONV_OK)
+    {
+        params.streamType.data = params.streamTypeStorage.c_str();
+        params.streamType.length = params.streamTypeStorage.length();
+        params.presentParams |= FOCUS_PARAM_STREAM_TYPE;
+    }
+    if ((allowedParams & FOCUS_PARAM_DISPLAY_ID) && payload["displayId"].asNumber(params.displayId) == CONV_OK)
+        params.presentParams |= FOCUS_PARAM_DISPLAY_ID;
+    if ((allowedParams & FOCUS_PARAM_SUBSCRIBE) && payload["subscribe"].asBool(params.subscribe) == CONV_OK)
+        params.presentParams |= FOCUS_PARAM_SUBSCRIBE;
+    int64_t focusHandle = 0;
+    if ((allowedParams & FOCUS_PARAM_FOCUS_HANDLE) && payload["focusHandle"].asNumber(focusHandle) == CONV_OK)
+    {
+        //A negative handle is kept as 0, which is never a valid one
+        params.focusHandle = (focusHandle > 0) ? (uint64_t) focusHandle : 0;
+        params.presentParams |= FOCUS_PARAM_FOCUS_HANDLE;
+    }
+}
+
 pbnjson::JValue createJsonReply(bool returnValue,
                                 int errorCode,
                                 const char *errorText)
@@ -155,13 +383,44 @@ std::string createJsonReplyString(bool returnValue,
     return reply;
 }
 
+std::string & appendJsonString(std::string & out, const char * value, size_t length)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    out += '"';
+    const char * plain = value;
+    const char * end = value + length;
+    for (const char * cursor = value; cursor < end; cursor++)
+    {
+        unsigned char c = (unsigned char) *cursor;
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        out.append(plain, cursor - plain);
+        plain = cursor + 1;
+        switch (c)
+        {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hexDigits[c >> 4];
+                out += hexDigits[c & 0xf];
+                break;
+        }
+    }
+    out.append(plain, end - plain);
+    out += '"';
+    return out;
+}
+
 std::string    jsonToString(pbnjson::JValue & reply, const char * schema)
 {
     pbnjson::JGenerator serializer(NULL);// our schema that we will be using
                                         // does not have any external references
     std::string serialized;
-    pbnjson::JSchemaFragment responseSchema(schema);
-    if (!serializer.toString(reply, responseSchema, serialized)) {
+    if (!serializer.toString(reply, getCachedSchema(schema), serialized)) {
         PM_LOG_ERROR(MSGID_MALFORMED_JSON, INIT_KVCOUNT, "serializeJsonReply: failed to generate json reply");
         return "{\"returnValue\":false,\"errorText\":\"audiod error: Failed to generate a valid json reply...\"}";
     }
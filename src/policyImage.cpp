@@ -0,0 +1,102 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "policyImage.h"
+#include "focusPolicy.h"
+#include <cstring>
+
+//FNV-1a, the image is small and only has to detect corruption
+uint32_t policyImageChecksum(const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *) data;
+    uint32_t hash = 2166136261u;
+    for (size_t index = 0; index < length; index++)
+    {
+        hash ^= bytes[index];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int32_t readPolicyConfigOption(const pbnjson::JValue& config, const char *key)
+{
+    if (!config.hasKey(key))
+        return AF_POLICY_IMAGE_OPTION_UNSET;
+    int32_t value = AF_POLICY_IMAGE_OPTION_INVALID;
+    if (config[key].asNumber(value) != CONV_OK)
+        return AF_POLICY_IMAGE_OPTION_INVALID;
+    return value;
+}
+
+void readPolicyConfigOptions(const pbnjson::JValue& config, int32_t& broadcastCoalesceMs, int32_t& displayCount)
+{
+    broadcastCoalesceMs = readPolicyConfigOption(config, AF_CONFIG_BROADCAST_COALESCE_MS);
+    displayCount = readPolicyConfigOption(config, AF_CONFIG_DISPLAY_COUNT);
+}
+
+bool buildPolicyImage(const FocusPolicy& policy, uint64_t sourceSize, int32_t broadcastCoalesceMs,
+                      int32_t displayCount, std::string& image)
+{
+    int requestTypeCount = policy.getRequestTypeCount();
+    POLICY_IMAGE_HEADER_T header;
+    memset(&header, 0, sizeof(header));
+    header.magic = AF_POLICY_IMAGE_MAGIC;
+    header.version = AF_POLICY_IMAGE_VERSION;
+    header.size = (uint32_t) (sizeof(header) + requestTypeCount * sizeof(POLICY_IMAGE_REQUEST_TYPE_T));
+    header.sourceSize = sourceSize;
+    header.broadcastCoalesceMs = broadcastCoalesceMs;
+    header.displayCount = displayCount;
+    header.requestTypeCount = (uint32_t) requestTypeCount;
+
+    image.assign((const char *) &header, sizeof(header));
+    for (int requestTypeId = 0; requestTypeId < requestTypeCount; requestTypeId++)
+    {
+        const std::string& name = policy.getRequestTypeName(requestTypeId);
+        if (name.length() >= AF_POLICY_IMAGE_NAME_SIZE)
+            return false;
+        POLICY_IMAGE_REQUEST_TYPE_T record;
+        memset(&record, 0, sizeof(record));
+        memcpy(record.name, name.c_str(), name.length());
+        record.priority = policy.getPriority(requestTypeId);
+        for (int incoming = 0; incoming < requestTypeCount; incoming++)
+            record.actions[incoming] = (uint8_t) policy.getAction(requestTypeId, incoming);
+        image.append((const char *) &record, sizeof(record));
+    }
+    uint32_t checksum = policyImageChecksum(image.data() + offsetof(POLICY_IMAGE_HEADER_T, sourceSize),
+                                            image.length() - offsetof(POLICY_IMAGE_HEADER_T, sourceSize));
+    image.replace(offsetof(POLICY_IMAGE_HEADER_T, checksum), sizeof(checksum), (const char *) &checksum,
+                  sizeof(checksum));
+    return true;
+}
+
+const POLICY_IMAGE_HEADER_T* validatePolicyImage(const void *data, size_t size)
+{
+    if (size < sizeof(POLICY_IMAGE_HEADER_T))
+        return nullptr;
+    const POLICY_IMAGE_HEADER_T *header = (const POLICY_IMAGE_HEADER_T *) data;
+    if (header->magic != AF_POLICY_IMAGE_MAGIC || header->version != AF_POLICY_IMAGE_VERSION)
+        return nullptr;
+    if (header->size != size || header->requestTypeCount == 0 || header->requestTypeCount > AF_MAX_REQUEST_TYPES ||
+        size != sizeof(POLICY_IMAGE_HEADER_T) + header->requestTypeCount * sizeof(POLICY_IMAGE_REQUEST_TYPE_T))
+        return nullptr;
+    const uint8_t *bytes = (const uint8_t *) data;
+    if (header->checksum != policyImageChecksum(bytes + offsetof(POLICY_IMAGE_HEADER_T, sourceSize),
+                                                size - offsetof(POLICY_IMAGE_HEADER_T, sourceSize)))
+        return nullptr;
+    return header;
+}
@@ -0,0 +1,44 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "symbolTable.h"
+
+int SymbolTable::intern(const std::string& name)
+{
+    auto result = mSymbolIdMap.emplace(name, (int) mSymbolNames.size());
+    //Keys of an unordered_map keep their address on rehash, so they can back the reverse lookup
+    if (result.second)
+        mSymbolNames.push_back(&result.first->first);
+    return result.first->second;
+}
+
+int SymbolTable::find(const std::string& name) const
+{
+    auto it = mSymbolIdMap.find(name);
+    if (it == mSymbolIdMap.end())
+        return AF_INVALID_SYMBOL;
+    return it->second;
+}
+
+const std::string& SymbolTable::getName(int symbolId) const
+{
+    static const std::string unknown;
+    if (symbolId < 0 || symbolId >= size())
+        return unknown;
+    return *mSymbolNames[symbolId];
+}
@@ -0,0 +1,476 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+/*
+ * afpolicy_test: checks of the focus engine and of the message parsing, run by ctest.
+ *
+ *   afpolicy_test <audiofocuspolicy.json>
+ *
+ * ->FocusEngine is driven with random requests, releases and cancels and compared after every
+ *   operation with a model of the original list based implementation, lists and events alike.
+ * ->The fast path of parseFocusRequestPayload has to give the same values as the pbnjson path
+ *   for every payload it accepts.
+ * ->The status delta of DisplayFocusState has to describe the changes since the snapshot.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <random>
+#include <pbnjson.hpp>
+#include "focusEngine.h"
+#include "messageUtils.h"
+
+#define AF_TEST_DISPLAY_COUNT 2
+#define AF_TEST_APP_COUNT 6
+#define AF_TEST_RANDOM_OPERATIONS 100000
+#define AF_TEST_RANDOM_SEED 20240101
+
+static int failures = 0;
+
+#define AF_TEST_EXPECT(condition, ...) \
+    do { if (!(condition)) { fprintf(stderr, "FAILED %s:%d: ", __FILE__, __LINE__); fprintf(stderr, __VA_ARGS__); \
+         fputc('\n', stderr); failures++; } } while (0)
+
+typedef struct ReferenceEntry
+{
+    std::string appId;
+    std::string requestType;
+    uint64_t focusHandle {0};
+}REFERENCE_ENTRY_T;
+
+typedef struct ReferenceEvent
+{
+    std::string appId;
+    std::string event;
+    uint64_t focusHandle;
+    bool operator==(const ReferenceEvent& other) const
+        { return appId == other.appId && event == other.event && focusHandle == other.focusHandle; }
+}REFERENCE_EVENT_T;
+
+typedef struct ReferenceDisplay
+{
+    std::list<REFERENCE_ENTRY_T> activeAppList;
+    std::list<REFERENCE_ENTRY_T> pausedAppList;
+}REFERENCE_DISPLAY_T;
+
+/*
+ * The list walks of the service before the focus engine, on strings and std::list as they were.
+ * Entries are named by the focus handle the engine gave them, so a cancel removes the very entry
+ * of the subscription.
+ */
+class ReferenceFocus
+{
+public:
+    explicit ReferenceFocus(const pbnjson::JValue& requestTypes) : mDisplays(AF_TEST_DISPLAY_COUNT)
+    {
+        for (const pbnjson::JValue& requestType : requestTypes.items())
+        {
+            std::map<std::string, std::string>& incoming = mIncoming[requestType["request"].asString()];
+            for (const pbnjson::JValue& element : requestType["incoming"].items())
+                for (const auto& action : element.children())
+                    incoming.emplace(action.first.asString(), action.second.asString());
+        }
+    }
+
+    std::vector<REFERENCE_EVENT_T> events;
+    REFERENCE_DISPLAY_T& getDisplay(int displayId)                  { return mDisplays[displayId]; }
+
+    std::string request(int displayId, const std::string& appId, const std::string& requestType)
+    {
+        REFERENCE_DISPLAY_T& display = mDisplays[displayId];
+        for (const auto* appList : {&display.pausedAppList, &display.activeAppList})
+            for (const auto& entry : *appList)
+                if (entry.appId == appId && entry.requestType == requestType)
+                    return "AF_GRANTEDALREADY";
+        for (const auto& entry : display.activeAppList)
+            if (!mIncoming[entry.requestType].count(requestType))
+                return "AF_CANNOTBEGRANTED";
+        for (auto itActive = display.activeAppList.begin(); itActive != display.activeAppList.end();)
+        {
+            std::string action = getAction(itActive->requestType, requestType);
+            if (action == "pause")
+            {
+                events.push_back({itActive->appId, "AF_PAUSE", itActive->focusHandle});
+                display.pausedAppList.push_back(*itActive);
+                itActive = display.activeAppList.erase(itActive);
+            }
+            else if (action == "lost")
+            {
+                events.push_back({itActive->appId, "AF_LOST", itActive->focusHandle});
+                itActive = display.activeAppList.erase(itActive);
+            }
+            else
+                ++itActive;
+        }
+        for (auto itPaused = display.pausedAppList.begin(); itPaused != display.pausedAppList.end();)
+        {
+            if (getAction(itPaused->requestType, requestType) == "lost")
+            {
+                events.push_back({itPaused->appId, "AF_LOST", itPaused->focusHandle});
+                itPaused = display.pausedAppList.erase(itPaused);
+            }
+            else
+                ++itPaused;
+        }
+        display.activeAppList.push_back({appId, requestType, 0});
+        return "AF_GRANTED";
+    }
+
+    //First paused entry of the application, or else its first active one
+    bool release(int displayId, const std::string& appId)
+    {
+        REFERENCE_DISPLAY_T& display = mDisplays[displayId];
+        for (auto* appList : {&display.pausedAppList, &display.activeAppList})
+        {
+            for (auto itApp = appList->begin(); itApp != appList->end(); ++itApp)
+            {
+                if (itApp->appId != appId)
+                    continue;
+                events.push_back({appId, "AF_RELEASED", itApp->focusHandle});
+                removeEntry(displayId, *appList, itApp);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void cancel(int displayId, uint64_t focusHandle)
+    {
+        REFERENCE_DISPLAY_T& display = mDisplays[displayId];
+        for (auto* appList : {&display.pausedAppList, &display.activeAppList})
+        {
+            for (auto itApp = appList->begin(); itApp != appList->end(); ++itApp)
+            {
+                if (itApp->focusHandle != focusHandle)
+                    continue;
+                removeEntry(displayId, *appList, itApp);
+                return;
+            }
+        }
+    }
+
+private:
+    std::map<std::string, std::map<std::string, std::string>> mIncoming;
+    std::vector<REFERENCE_DISPLAY_T> mDisplays;
+
+    std::string getAction(const std::string& requestType, const std::string& incomingRequestType)
+    {
+        auto& incoming = mIncoming[requestType];
+        auto itAction = incoming.find(incomingRequestType);
+        return (itAction == incoming.end()) ? "" : itAction->second;
+    }
+
+    void removeEntry(int displayId, std::list<REFERENCE_ENTRY_T>& appList, std::list<REFERENCE_ENTRY_T>::iterator itApp)
+    {
+        REFERENCE_DISPLAY_T& display = mDisplays[displayId];
+        bool paused = (&appList == &display.pausedAppList);
+        std::string requestType = itApp->requestType;
+        appList.erase(itApp);
+        if (!paused)
+            pausedAppToActive(display, requestType);
+    }
+
+    void pausedAppToActive(REFERENCE_DISPLAY_T& display, const std::string& removedRequestType)
+    {
+        if (display.pausedAppList.size() == 1 && display.activeAppList.empty())
+        {
+            events.push_back({display.pausedAppList.back().appId, "AF_GRANTED", display.pausedAppList.back().focusHandle});
+            display.activeAppList.push_back(display.pausedAppList.back());
+            display.pausedAppList.pop_back();
+            return;
+        }
+        for (auto itPaused = display.pausedAppList.begin(); itPaused != display.pausedAppList.end();)
+        {
+            if (getAction(itPaused->requestType, removedRequestType) == "pause" && \
+                isIncomingPairRequestTypeActive(itPaused->requestType, display))
+            {
+                events.push_back({itPaused->appId, "AF_GRANTED", itPaused->focusHandle});
+                display.activeAppList.push_back(*itPaused);
+                itPaused = display.pausedAppList.erase(itPaused);
+            }
+            else
+                ++itPaused;
+        }
+    }
+
+    bool isIncomingPairRequestTypeActive(const std::string& requestType, const REFERENCE_DISPLAY_T& display)
+    {
+        for (const auto& entry : display.activeAppList)
+            if (getAction(requestType, entry.requestType) != "mix")
+                return false;
+        return true;
+    }
+};
+
+static bool sameAppList(const FocusEngine& engine, const AppInfoList& appList, const std::list<REFERENCE_ENTRY_T>& referenceList,
+                        int displayId)
+{
+    if (appList.size() != referenceList.size())
+        return false;
+    auto itReference = referenceList.begin();
+    for (const auto& appInfo : appList)
+    {
+        if (engine.getSymbolTable().getName(appInfo.appId) != itReference->appId || \
+            engine.getPolicy().getRequestTypeName(appInfo.requestTypeId) != itReference->requestType || \
+            FocusEngine::makeFocusHandle(displayId, appInfo.entryId) != itReference->focusHandle)
+            return false;
+        ++itReference;
+    }
+    return true;
+}
+
+static std::vector<REFERENCE_EVENT_T> toReferenceEvents(const FocusEngine& engine, const AppNotificationList& notifications)
+{
+    std::vector<REFERENCE_EVENT_T> events;
+    for (const auto& notification : notifications)
+        events.push_back({engine.getSymbolTable().getName(notification.appId), notification.event, notification.focusHandle});
+    return events;
+}
+
+/*
+ * Functionality of this method:
+ * ->Runs the same random operations on the engine and on the reference, and stops at the first
+ *   operation after which their lists or their events differ.
+ */
+static void testFocusEngineAgainstReference(const pbnjson::JValue& requestTypes)
+{
+    FocusEngine engine(AF_TEST_DISPLAY_COUNT);
+    AF_TEST_EXPECT(engine.loadPolicyFromJson(requestTypes), "the policy does not load");
+    ReferenceFocus reference(requestTypes);
+    std::mt19937 random(AF_TEST_RANDOM_SEED);
+    int requestTypeCount = engine.getPolicy().getRequestTypeCount();
+    std::map<uint64_t, std::string> handleOwners;
+    for (int operation = 0; operation < AF_TEST_RANDOM_OPERATIONS && !failures; operation++)
+    {
+        int displayId = (int) (random() % AF_TEST_DISPLAY_COUNT);
+        std::string appId = "com.webos.app.test" + std::to_string(random() % AF_TEST_APP_COUNT);
+        AppNotificationList notifications;
+        reference.events.clear();
+        unsigned int kind = random() % 10;
+        if (kind < 5)
+        {
+            int requestTypeId = (int) (random() % requestTypeCount);
+            const std::string& requestType = engine.getPolicy().getRequestTypeName(requestTypeId);
+            const char* result = nullptr;
+            uint64_t focusHandle = 0;
+            bool granted = engine.requestFocus(displayId, appId.c_str(), requestTypeId, "pcm_output", notifications,
+                result, focusHandle);
+            std::string referenceResult = reference.request(displayId, appId, requestType);
+            AF_TEST_EXPECT(referenceResult == result, "operation %d: request %s of %s gives %s, expected %s", operation,
+                requestType.c_str(), appId.c_str(), result, referenceResult.c_str());
+            AF_TEST_EXPECT(granted == (referenceResult == "AF_GRANTED"), "operation %d: granted %d", operation, granted);
+            if (granted)
+            {
+                reference.getDisplay(displayId).activeAppList.back().focusHandle = focusHandle;
+                handleOwners[focusHandle] = appId;
+            }
+        }
+        else if (kind < 8)
+        {
+            bool released = engine.releaseFocus(displayId, appId.c_str(), nullptr, 0, notifications);
+            AF_TEST_EXPECT(released == reference.release(displayId, appId), "operation %d: release of %s gives %d",
+                operation, appId.c_str(), released);
+        }
+        else if (!handleOwners.empty())
+        {
+            auto itOwner = std::next(handleOwners.begin(), random() % handleOwners.size());
+            int handleDisplayId = -1;
+            uint64_t entryId = 0;
+            FocusEngine::splitFocusHandle(itOwner->first, handleDisplayId, entryId);
+            std::set<int> changedDisplays;
+            engine.cancelFocus(itOwner->second.c_str(), std::vector<uint64_t>(1, itOwner->first), notifications,
+                changedDisplays);
+            reference.cancel(handleDisplayId, itOwner->first);
+            handleOwners.erase(itOwner);
+        }
+        AF_TEST_EXPECT(toReferenceEvents(engine, notifications) == reference.events, "operation %d: events differ",
+            operation);
+        for (int checkedDisplayId = 0; checkedDisplayId < AF_TEST_DISPLAY_COUNT; checkedDisplayId++)
+        {
+            const DisplayFocusState& displayInfo = engine.getDisplay(checkedDisplayId);
+            REFERENCE_DISPLAY_T& referenceDisplay = reference.getDisplay(checkedDisplayId);
+            AF_TEST_EXPECT(sameAppList(engine, displayInfo.getActiveAppList(), referenceDisplay.activeAppList,
+                checkedDisplayId), "operation %d: active list of display %d differs", operation, checkedDisplayId);
+            AF_TEST_EXPECT(sameAppList(engine, displayInfo.getPausedAppList(), referenceDisplay.pausedAppList,
+                checkedDisplayId), "operation %d: paused list of display %d differs", operation, checkedDisplayId);
+        }
+    }
+}
+
+static bool sameFocusRequestParams(const FOCUS_REQUEST_PARAMS_T& fast, const FOCUS_REQUEST_PARAMS_T& regular)
+{
+    return fast.presentParams == regular.presentParams && fast.requestType.str() == regular.requestType.str() && \
+        fast.streamType.str() == regular.streamType.str() && \
+        (!(fast.presentParams & FOCUS_PARAM_DISPLAY_ID) || fast.displayId == regular.displayId) && \
+        (!(fast.presentParams & FOCUS_PARAM_SUBSCRIBE) || fast.subscribe == regular.subscribe) && \
+        fast.focusHandle == regular.focusHandle;
+}
+
+/*
+ * Functionality of this method:
+ * ->A payload taken by the fast path must pass the schema and give the same values through
+ *   pbnjson. A payload the schema rejects must be left to the regular path.
+ */
+static void checkFocusRequestPayload(const char* schema, unsigned int allowedParams, unsigned int requiredParams,
+                                     const char* payload)
+{
+    FOCUS_REQUEST_PARAMS_T fast;
+    bool fastParsed = parseFocusRequestPayload(payload, allowedParams, requiredParams, fast);
+    JsonMessageParser parser(payload, schema);
+    bool regularParsed = parser.parse(__FUNCTION__);
+    if (!fastParsed)
+        return;
+    AF_TEST_EXPECT(regularParsed, "fast path accepts '%s' which the schema rejects", payload);
+    if (!regularParsed)
+        return;
+    FOCUS_REQUEST_PARAMS_T regular;
+    readFocusRequestParams(parser.get(), allowedParams, regular);
+    AF_TEST_EXPECT(sameFocusRequestParams(fast, regular), "fast path reads '%s' differently", payload);
+}
+
+static void testFocusRequestPayloads()
+{
+    const char* requestSchema = STRICT_SCHEMA(PROPS_4(PROP(requestType, string), PROP(displayId, integer),
+        PROP(subscribe, boolean), PROP(streamType, string)) REQUIRED_4(requestType, displayId, subscribe, streamType));
+    const unsigned int requestParams = FOCUS_PARAM_REQUEST_TYPE | FOCUS_PARAM_DISPLAY_ID | FOCUS_PARAM_SUBSCRIBE | \
+        FOCUS_PARAM_STREAM_TYPE;
+    const char* requestPayloads[] =
+    {
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":0,\"subscribe\":true,\"streamType\":\"pmedia\"}",
+        " { \"subscribe\" : false , \"streamType\":\"\", \"displayId\" : 1,\"requestType\":\"AFREQUEST_CALL\" } ",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":-1,\"subscribe\":true,\"streamType\":\"pmedia\"}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":1.0,\"subscribe\":true,\"streamType\":\"pmedia\"}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":1e0,\"subscribe\":true,\"streamType\":\"pmedia\"}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":01,\"subscribe\":true,\"streamType\":\"pmedia\"}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":9999999999,\"subscribe\":true,\"streamType\":\"pmedia\"}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":\"0\",\"subscribe\":true,\"streamType\":\"pmedia\"}",
+        "{\"requestType\":\"AFREQUEST_\\u0047AIN\",\"displayId\":0,\"subscribe\":true,\"streamType\":\"pmedia\"}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":0,\"subscribe\":true}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":0,\"subscribe\":true,\"streamType\":\"pmedia\",\"extra\":1}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"requestType\":\"AFREQUEST_CALL\",\"displayId\":0,\"subscribe\":true,"
+            "\"streamType\":\"pmedia\"}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":0,\"subscribe\":1,\"streamType\":\"pmedia\"}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":0,\"subscribe\":true,\"streamType\":\"pmedia\"} x",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":0,\"subscribe\":true,\"streamType\":\"pmedia\",}",
+        "{\"requestType\":\"AFREQUEST_GAIN\",\"displayId\":0,\"subscribe\":true,\"streamType\":[\"pmedia\"]}",
+        "{}",
+        "",
+    };
+    for (const char* payload : requestPayloads)
+        checkFocusRequestPayload(requestSchema, requestParams, requestParams, payload);
+
+    const char* releaseSchema = STRICT_SCHEMA(PROPS_3(PROP(displayId, integer), PROP(streamType, string),
+        PROP(focusHandle, integer)) REQUIRED_1(displayId));
+    const unsigned int releaseParams = FOCUS_PARAM_DISPLAY_ID | FOCUS_PARAM_STREAM_TYPE | FOCUS_PARAM_FOCUS_HANDLE;
+    const char* releasePayloads[] =
+    {
+        "{\"displayId\":0,\"streamType\":\"pmedia\"}",
+        "{\"displayId\":0,\"focusHandle\":512}",
+        "{\"displayId\":1,\"focusHandle\":0}",
+        "{\"displayId\":1,\"focusHandle\":-256}",
+        "{\"displayId\":1,\"focusHandle\":123456789012345}",
+        "{\"displayId\":1,\"focusHandle\":1234567890123456}",
+        "{\"streamType\":\"pmedia\"}",
+    };
+    for (const char* payload : releasePayloads)
+        checkFocusRequestPayload(releaseSchema, releaseParams, FOCUS_PARAM_DISPLAY_ID, payload);
+}
+
+static bool containsEntry(const std::vector<const APP_INFO_T*>& entries, uint64_t entryId)
+{
+    for (const APP_INFO_T* appInfo : entries)
+        if (appInfo->entryId == entryId)
+            return true;
+    return false;
+}
+
+/*
+ * Functionality of this method:
+ * ->Between two snapshots an entry removed, paused or added shows up in the delta, an entry
+ *   left alone does not. Right after a snapshot the delta is empty.
+ */
+static void testStatusDelta()
+{
+    DisplayFocusState displayInfo;
+    APP_INFO_T appInfo;
+    appInfo.requestTypeId = 0;
+    appInfo.appId = 1;
+    uint64_t keptEntryId = displayInfo.addActiveApp(appInfo)->entryId;
+    appInfo.appId = 2;
+    auto itPaused = displayInfo.addActiveApp(appInfo);
+    uint64_t pausedEntryId = itPaused->entryId;
+    appInfo.appId = 3;
+    auto itRemoved = displayInfo.addActiveApp(appInfo);
+    uint64_t removedEntryId = itRemoved->entryId;
+    uint64_t sequence = displayInfo.takeStatusSnapshot();
+    AF_TEST_EXPECT(displayInfo.isStatusSnapshotCurrent(), "snapshot is not current after it was taken");
+
+    displayInfo.pauseActiveApp(itPaused);
+    displayInfo.removeActiveApp(itRemoved);
+    appInfo.appId = 4;
+    uint64_t addedEntryId = displayInfo.addActiveApp(appInfo)->entryId;
+    AF_TEST_EXPECT(!displayInfo.isStatusSnapshotCurrent(), "snapshot is current after changes");
+
+    std::vector<uint64_t> removedEntryIds;
+    std::vector<const APP_INFO_T*> appendedActive;
+    std::vector<const APP_INFO_T*> appendedPaused;
+    displayInfo.getStatusDelta(removedEntryIds, appendedActive, appendedPaused);
+    std::set<uint64_t> removed(removedEntryIds.begin(), removedEntryIds.end());
+    AF_TEST_EXPECT(removed == std::set<uint64_t>({pausedEntryId, removedEntryId}), "removed entries differ");
+    AF_TEST_EXPECT(appendedActive.size() == 1 && containsEntry(appendedActive, addedEntryId), "appended active differ");
+    AF_TEST_EXPECT(appendedPaused.size() == 1 && containsEntry(appendedPaused, pausedEntryId), "appended paused differ");
+    AF_TEST_EXPECT(!removed.count(keptEntryId) && !containsEntry(appendedActive, keptEntryId), "kept entry in delta");
+
+    AF_TEST_EXPECT(displayInfo.takeStatusSnapshot() == sequence + 1, "snapshot sequence does not follow");
+    removedEntryIds.clear();
+    appendedActive.clear();
+    appendedPaused.clear();
+    displayInfo.getStatusDelta(removedEntryIds, appendedActive, appendedPaused);
+    AF_TEST_EXPECT(removedEntryIds.empty() && appendedActive.empty() && appendedPaused.empty(),
+        "delta is not empty after a snapshot");
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: afpolicy_test <audiofocuspolicy.json>\n");
+        return 2;
+    }
+    pbnjson::JValue config = pbnjson::JDomParser::fromFile(argv[1], pbnjson::JSchema::AllSchema());
+    if (!config.isObject() || !config["requestType"].isArray())
+    {
+        fprintf(stderr, "afpolicy_test: cannot read %s\n", argv[1]);
+        return 2;
+    }
+    testFocusEngineAgainstReference(config["requestType"]);
+    testFocusRequestPayloads();
+    testStatusDelta();
+    if (failures)
+    {
+        fprintf(stderr, "afpolicy_test: %d checks failed\n", failures);
+        return 1;
+    }
+    printf("afpolicy_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,363 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2024 LG Electronics Company.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+/*
+ * afpolicyc: checks audiofocuspolicy.json and compiles it into the policy image
+ * loaded by the service at startup.
+ *
+ *   afpolicyc [--strict] <audiofocuspolicy.json> <audiofocuspolicy.bin>
+ *   afpolicyc [--strict] --header <audiofocuspolicy.json> <defaultFocusPolicy.h>
+ *
+ * With --header the policy is written as the constexpr DefaultFocusPolicy built into the service.
+ * Errors (unknown request types, bad actions, duplicates, invalid options) fail the build.
+ * Warnings (asymmetric or missing pairs) are only reported, unless --strict is given.
+ * The output is written next to its final name and renamed, a failed run leaves no output.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <pbnjson.hpp>
+#include "focusPolicy.h"
+#include "policyImage.h"
+
+typedef struct PolicyCheck
+{
+    int errors {0};
+    int warnings {0};
+}POLICY_CHECK_T;
+
+#define AF_POLICYC_ERROR(check, ...) \
+    do { fprintf(stderr, "afpolicyc: error: " __VA_ARGS__); fputc('\n', stderr); (check).errors++; } while (0)
+#define AF_POLICYC_WARNING(check, ...) \
+    do { fprintf(stderr, "afpolicyc: warning: " __VA_ARGS__); fputc('\n', stderr); (check).warnings++; } while (0)
+
+static bool readFile(const char *path, std::string& content)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+    char buffer[4096];
+    size_t length = 0;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        content.append(buffer, length);
+    bool readError = ferror(file);
+    fclose(file);
+    return !readError;
+}
+
+static bool writeFile(const char *path, const std::string& content)
+{
+    std::string tmpPath = std::string(path) + ".tmp";
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (!file)
+        return false;
+    bool written = fwrite(content.data(), 1, content.length(), file) == content.length();
+    written = (fclose(file) == 0) && written;
+    if (!written || rename(tmpPath.c_str(), path) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Functionality of this method:
+ * ->Checks what FocusPolicy::loadFromJson would only log and skip.
+ * ->actions[active][incoming] is filled with the first action found for each pair, as the service does.
+ */
+static void checkRequestTypes(const pbnjson::JValue& requestTypeArray, POLICY_CHECK_T& check)
+{
+    if (!requestTypeArray.isArray() || requestTypeArray.arraySize() == 0)
+    {
+        AF_POLICYC_ERROR(check, "\"requestType\" is not a non empty array");
+        return;
+    }
+    std::vector<std::string> requestTypes;
+    std::map<std::string, int> requestTypeIds;
+    for (const pbnjson::JValue& elements : requestTypeArray.items())
+    {
+        std::string requestType;
+        if (!elements.isObject() || elements["request"].asString(requestType) != CONV_OK || requestType.empty())
+        {
+            AF_POLICYC_ERROR(check, "request type entry without a \"request\" name");
+            continue;
+        }
+        if (requestTypeIds.count(requestType))
+        {
+            AF_POLICYC_ERROR(check, "duplicate request type %s", requestType.c_str());
+            continue;
+        }
+        if (requestType.length() >= AF_POLICY_IMAGE_NAME_SIZE)
+            AF_POLICYC_ERROR(check, "request type name %s is longer than %d", requestType.c_str(),
+                             AF_POLICY_IMAGE_NAME_SIZE - 1);
+        if (!elements["priority"].isNumber())
+            AF_POLICYC_WARNING(check, "request type %s has no priority", requestType.c_str());
+        requestTypeIds[requestType] = (int) requestTypes.size();
+        requestTypes.push_back(requestType);
+    }
+    if (requestTypes.size() > AF_MAX_REQUEST_TYPES)
+    {
+        AF_POLICYC_ERROR(check, "%d request types, at most %d are supported", (int) requestTypes.size(),
+                         AF_MAX_REQUEST_TYPES);
+        return;
+    }
+
+    FOCUS_ACTION_E actions[AF_MAX_REQUEST_TYPES][AF_MAX_REQUEST_TYPES] = {};
+    for (const pbnjson::JValue& elements : requestTypeArray.items())
+    {
+        std::string requestType;
+        if (!elements.isObject() || elements["request"].asString(requestType) != CONV_OK || \
+            !requestTypeIds.count(requestType))
+            continue;
+        int active = requestTypeIds[requestType];
+        pbnjson::JValue incomingRequestInfo = elements["incoming"];
+        if (!incomingRequestInfo.isArray())
+        {
+            AF_POLICYC_ERROR(check, "incoming list of %s is not an array", requestType.c_str());
+            continue;
+        }
+        for (const pbnjson::JValue& incoming : incomingRequestInfo.items())
+        {
+            if (!incoming.isObject())
+            {
+                AF_POLICYC_ERROR(check, "incoming entry of %s is not an object", requestType.c_str());
+                continue;
+            }
+            for (const auto& pair : incoming.children())
+            {
+                std::string incomingRequestType = pair.first.asString();
+                std::string actionName;
+                auto itIncoming = requestTypeIds.find(incomingRequestType);
+                if (itIncoming == requestTypeIds.end())
+                {
+                    AF_POLICYC_ERROR(check, "unknown incoming request type %s for %s", incomingRequestType.c_str(),
+                                     requestType.c_str());
+                    continue;
+                }
+                FOCUS_ACTION_E action = eFocusActionNone;
+                if (pair.second.asString(actionName) == CONV_OK)
+                    action = FocusPolicy::actionFromString(actionName);
+                if (action == eFocusActionNone)
+                {
+                    AF_POLICYC_ERROR(check, "invalid action for %s incoming %s", requestType.c_str(),
+                                     incomingRequestType.c_str());
+                    continue;
+                }
+                if (actions[active][itIncoming->second] != eFocusActionNone)
+                {
+                    AF_POLICYC_WARNING(check, "%s incoming %s given twice, the first one is used", requestType.c_str(),
+                                       incomingRequestType.c_str());
+                    continue;
+                }
+                actions[active][itIncoming->second] = action;
+            }
+        }
+    }
+
+    //A missing entry means the incoming request is never granted while the other one is active
+    for (size_t first = 0; first < requestTypes.size(); first++)
+    {
+        for (size_t second = first; second < requestTypes.size(); second++)
+        {
+            bool firstListsSecond = actions[first][second] != eFocusActionNone;
+            bool secondListsFirst = actions[second][first] != eFocusActionNone;
+            if (!firstListsSecond && !secondListsFirst)
+                AF_POLICYC_WARNING(check, "missing pair %s / %s", requestTypes[first].c_str(),
+                                   requestTypes[second].c_str());
+            else if (firstListsSecond != secondListsFirst)
+                AF_POLICYC_WARNING(check, "asymmetric pair: %s lists %s but not the other way", \
+                    (firstListsSecond ? requestTypes[first] : requestTypes[second]).c_str(),
+                    (firstListsSecond ? requestTypes[second] : requestTypes[first]).c_str());
+        }
+    }
+}
+
+static const char* actionToEnumName(FOCUS_ACTION_E action)
+{
+    switch (action)
+    {
+        case eFocusActionMix:
+            return "eFocusActionMix";
+        case eFocusActionPause:
+            return "eFocusActionPause";
+        case eFocusActionLost:
+            return "eFocusActionLost";
+        default:
+            return "eFocusActionNone";
+    }
+}
+
+//Same layout as the checked in include/defaultFocusPolicy.h, which is the output for the shipped json
+static void buildDefaultPolicyHeader(const FocusPolicy& policy, std::string& header)
+{
+    int requestTypeCount = policy.getRequestTypeCount();
+    header = "/* @@@LICENSE\n"
+        "*\n"
+        "*      Copyright (c) 2024 LG Electronics Company.\n"
+        "*\n"
+        "* Licensed under the Apache License, Version 2.0 (the \"License\");\n"
+        "* you may not use this file except in compliance with the License.\n"
+        "* You may obtain a copy of the License at\n"
+        "*\n"
+        "* http://www.apache.org/licenses/LICENSE-2.0\n"
+        "*\n"
+        "* Unless required by applicable law or agreed to in writing, software\n"
+        "* distributed under the License is distributed on an \"AS IS\" BASIS,\n"
+        "* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n"
+        "* See the License for the specific language governing permissions and\n"
+        "* limitations under the License.\n"
+        "*\n"
+        "* LICENSE@@@ */\n"
+        "\n"
+        "//Generated by afpolicyc --header from audiofocuspolicy.json, do not edit\n"
+        "\n"
+        "#ifndef DEFAULT_FOCUS_POLICY_H_\n"
+        "#define DEFAULT_FOCUS_POLICY_H_\n"
+        "\n"
+        "#include \"focusTypes.h\"\n"
+        "\n"
+        "/*\n"
+        " * Built-in copy of the shipped audiofocuspolicy.json, used when no policy can be loaded\n"
+        " * from the filesystem. Request type ids follow the order of the json, as in FocusPolicy.\n"
+        " */\n"
+        "class DefaultFocusPolicy\n"
+        "{\n"
+        "public:\n";
+    header += "    static constexpr int requestTypeCount = " + std::to_string(requestTypeCount) + ";\n"
+        "\n"
+        "    static constexpr const char* getRequestTypeName(int requestTypeId)\n"
+        "    {\n"
+        "        constexpr const char* requestTypeNames[requestTypeCount] = {\n";
+    for (int requestTypeId = 0; requestTypeId < requestTypeCount; requestTypeId++)
+        header += "            \"" + policy.getRequestTypeName(requestTypeId) + "\",\n";
+    header += "        };\n"
+        "        return requestTypeNames[requestTypeId];\n"
+        "    }\n"
+        "\n"
+        "    static constexpr int getPriority(int requestTypeId)\n"
+        "    {\n"
+        "        constexpr int priorities[requestTypeCount] = {";
+    for (int requestTypeId = 0; requestTypeId < requestTypeCount; requestTypeId++)
+        header += (requestTypeId ? ", " : "") + std::to_string(policy.getPriority(requestTypeId));
+    header += "};\n"
+        "        return priorities[requestTypeId];\n"
+        "    }\n"
+        "\n"
+        "    //Rows are the active request type, columns the incoming one\n"
+        "    static constexpr FOCUS_ACTION_E getAction(int activeRequestTypeId, int incomingRequestTypeId)\n"
+        "    {\n"
+        "        constexpr FOCUS_ACTION_E actions[requestTypeCount][requestTypeCount] = {\n";
+    for (int active = 0; active < requestTypeCount; active++)
+    {
+        header += "            //" + policy.getRequestTypeName(active) + "\n            {";
+        for (int incoming = 0; incoming < requestTypeCount; incoming++)
+        {
+            header += incoming ? ", " : "";
+            header += actionToEnumName(policy.getAction(active, incoming));
+        }
+        header += "},\n";
+    }
+    header += "        };\n"
+        "        return actions[activeRequestTypeId][incomingRequestTypeId];\n"
+        "    }\n"
+        "};\n"
+        "\n"
+        "#endif //DEFAULT_FOCUS_POLICY_H_\n";
+}
+
+int main(int argc, char **argv)
+{
+    bool strict = false;
+    bool header = false;
+    int argIndex = 1;
+    for (; argIndex < argc && strncmp(argv[argIndex], "--", 2) == 0; argIndex++)
+    {
+        if (strcmp(argv[argIndex], "--strict") == 0)
+            strict = true;
+        else if (strcmp(argv[argIndex], "--header") == 0)
+            header = true;
+        else
+            break;
+    }
+    if (argc - argIndex != 2)
+    {
+        fprintf(stderr, "usage: afpolicyc [--strict] [--header] <audiofocuspolicy.json> <output>\n");
+        return 2;
+    }
+    const char *jsonPath = argv[argIndex];
+    const char *outputPath = argv[argIndex + 1];
+
+    std::string source;
+    if (!readFile(jsonPath, source))
+    {
+        fprintf(stderr, "afpolicyc: error: cannot read %s\n", jsonPath);
+        return 1;
+    }
+    pbnjson::JValue config = pbnjson::JDomParser::fromString(source, pbnjson::JSchema::AllSchema());
+    if (!config.isValid() || !config.isObject())
+    {
+        fprintf(stderr, "afpolicyc: error: %s is not a json object\n", jsonPath);
+        return 1;
+    }
+
+    POLICY_CHECK_T check;
+    checkRequestTypes(config["requestType"], check);
+    int32_t broadcastCoalesceMs = AF_POLICY_IMAGE_OPTION_UNSET;
+    int32_t displayCount = AF_POLICY_IMAGE_OPTION_UNSET;
+    readPolicyConfigOptions(config, broadcastCoalesceMs, displayCount);
+    if (broadcastCoalesceMs != AF_POLICY_IMAGE_OPTION_UNSET && \
+        (broadcastCoalesceMs < 0 || broadcastCoalesceMs > AF_MAX_BROADCAST_COALESCE_MS))
+        AF_POLICYC_ERROR(check, "%s must be within 0 and %d", AF_CONFIG_BROADCAST_COALESCE_MS,
+                         AF_MAX_BROADCAST_COALESCE_MS);
+    if (displayCount != AF_POLICY_IMAGE_OPTION_UNSET && (displayCount <= 0 || displayCount > AF_MAX_DISPLAY_COUNT))
+        AF_POLICYC_ERROR(check, "%s must be within 1 and %d", AF_CONFIG_DISPLAY_COUNT, AF_MAX_DISPLAY_COUNT);
+    if (check.errors || (strict && check.warnings))
+    {
+        fprintf(stderr, "afpolicyc: %s: %d errors, %d warnings, nothing written\n", jsonPath, check.errors,
+                check.warnings);
+        return 1;
+    }
+
+    FocusPolicy focusPolicy;
+    std::string output;
+    if (!focusPolicy.loadFromJson(config["requestType"]))
+    {
+        fprintf(stderr, "afpolicyc: error: cannot compile %s\n", jsonPath);
+        return 1;
+    }
+    if (header)
+        buildDefaultPolicyHeader(focusPolicy, output);
+    else if (!buildPolicyImage(focusPolicy, (uint64_t) source.length(), broadcastCoalesceMs,
+                               displayCount, output))
+    {
+        fprintf(stderr, "afpolicyc: error: cannot compile %s\n", jsonPath);
+        return 1;
+    }
+    if (!writeFile(outputPath, output))
+    {
+        fprintf(stderr, "afpolicyc: error: cannot write %s\n", outputPath);
+        return 1;
+    }
+    printf("afpolicyc: %s: %d request types, %d warnings, %d bytes written to %s\n", jsonPath,
+           focusPolicy.getRequestTypeCount(), check.warnings, (int) output.length(), outputPath);
+    return 0;
+}